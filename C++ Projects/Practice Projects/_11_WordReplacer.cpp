@@ -2,6 +2,7 @@
 #include <vector>
 #include <string>
 #include <limits>
+#include "../simd_find.h"
 
 using namespace std;
 
@@ -39,15 +40,20 @@ string replaceString(string inputString, string targetWord, string replacementWo
         return inputString;
     }
 
-    string s2 = inputString; // Create a copy to preserve the original input
-    size_t pos = 0;          // Start search from the beginning
+    string s2;        // Output string, built left to right
+    size_t start = 0; // End of the part of the input already copied
+    size_t pos = 0;   // Position of the next occurrence
 
-    // Loop to find and replace all occurrences
-    while ((pos = s2.find(targetWord, pos)) != string::npos)
+    // Copy the text between occurrences and the replacement for each occurrence,
+    // instead of replacing inside the string (which shifts the rest of it every time)
+    s2.reserve(inputString.length());
+    while ((pos = simdFind(inputString, targetWord, start)) != string::npos)
     {
-        s2.replace(pos, targetWord.length(), replacementWord);
-        pos += replacementWord.length(); // Move past the replaced word to continue searching
+        s2.append(inputString, start, pos - start);
+        s2 += replacementWord;
+        start = pos + targetWord.length(); // Move past the replaced word to continue searching
     }
+    s2.append(inputString, start, string::npos);
 
     if (inputString == s2)
         cout << "Target word not found. No replacements made." << endl;
@@ -2,6 +2,7 @@
 #include <vector>
 #include <string>
 #include <limits>
+#include "../simd_find.h"
 using namespace std;
 
 // Removes leading and trailing spaces from a string
@@ -37,30 +38,35 @@ string tolowerString(string s)
 /*
  * This function splits the input string `s` into substrings separated by the specified `delimiter`.
  * Each non-empty substring is added to the vector `vWords`.
+ * The string is walked with offsets (simdFind) instead of being erased from the front after every word.
  */
-void splitStringToWords(string s, vector<string> &vWords, string delimiter)
+void splitStringToWords(const string &s, vector<string> &vWords, const string &delimiter)
 {
 
-    short pos = 0;   // Position of the delimiter in the string
-    string tempWord; // Temporary string to hold the current word
+    size_t start = 0; // Start of the current word
+    size_t pos = 0;   // Position of the delimiter in the string
 
-    // Loop as long as the delimiter is found in the string
-    while ((pos = s.find(delimiter)) != std::string::npos)
+    if (delimiter.empty())
     {
-        // Extract the substring from the start up to the delimiter position
-        tempWord = s.substr(0, pos);
+        if (!s.empty())
+            vWords.push_back(s);
+        return;
+    }
 
-        // Add the substring to the vector only if it is not empty
-        if (tempWord != "")
-            vWords.push_back(tempWord);
+    // Loop as long as the delimiter is found in the rest of the string
+    while ((pos = simdFind(s, delimiter, start)) != string::npos)
+    {
+        // Add the substring between the previous delimiter and this one only if it is not empty
+        if (pos > start)
+            vWords.push_back(s.substr(start, pos - start));
 
-        // Remove the extracted word and the delimiter from the original string
-        s.erase(0, pos + delimiter.length());
+        // Continue right after the delimiter
+        start = pos + delimiter.length();
     }
 
     // After the loop ends, add any remaining part of the string as the last word if not empty
-    if (s != "")
-        vWords.push_back(s);
+    if (start < s.length())
+        vWords.push_back(s.substr(start));
 }
 
 void replaceWordInVector(vector<string> &vWords, string targetWord, string replacementWord, bool matchCase = false)
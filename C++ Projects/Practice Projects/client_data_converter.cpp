@@ -2,6 +2,7 @@
 #include <vector>
 #include <string>
 #include <limits>
+#include "../simd_find.h"
 using namespace std;
 
 /*
@@ -61,31 +62,35 @@ short readNum(string message = "Please enter a number: ")
 /*
  * This function splits the input string `s` into substrings separated by the specified `delimiter`.
  * Each non-empty substring is added to the vector `vWords`.
+ * The string is walked with offsets (simdFind) instead of being erased from the front after every word.
  */
-void splitString(string s, vector<string> &vWords, string delimiter)
+void splitString(const string &s, vector<string> &vWords, const string &delimiter)
 {
 
-    short pos = 0;   // Position of the delimiter in the string
-    string tempWord; // Temporary string to hold the current word
-
-    // Loop as long as the delimiter is found in the string
-    while ((pos = s.find(delimiter)) != std::string::npos)
+    size_t start = 0; // Start of the current word
+    size_t pos = 0;   // Position of the delimiter in the string
 
+    if (delimiter.empty())
     {
-        // Extract the substring from the start up to the delimiter position
-        tempWord = s.substr(0, pos);
+        if (!s.empty())
+            vWords.push_back(s);
+        return;
+    }
 
-        // Add the substring to the vector only if it is not empty
-        if (tempWord != "")
-            vWords.push_back(tempWord);
+    // Loop as long as the delimiter is found in the rest of the string
+    while ((pos = simdFind(s, delimiter, start)) != string::npos)
+    {
+        // Add the substring between the previous delimiter and this one only if it is not empty
+        if (pos > start)
+            vWords.push_back(s.substr(start, pos - start));
 
-        // Remove the extracted word and the delimiter from the original string
-        s.erase(0, pos + delimiter.length());
+        // Continue right after the delimiter
+        start = pos + delimiter.length();
     }
 
     // After the loop ends, add any remaining part of the string as the last word if not empty
-    if (s != "")
-        vWords.push_back(s);
+    if (start < s.length())
+        vWords.push_back(s.substr(start));
 }
 // Represents a bank client with basic account and contact information
 struct sClient
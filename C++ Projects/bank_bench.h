@@ -0,0 +1,517 @@
+#ifndef BANK_BENCH_H
+#define BANK_BENCH_H
+
+/*
+=======================================
+Bank benchmarks — measurements of the store and its storage
+=======================================
+
+- --bench-load: the getline, mmap, threaded mmap and checkpoint loaders in MB/s.
+- --memory-report: bytes per client of the client slots, the columns and the indexes against sClient records.
+- --bench-transactions: transactions/sec one by one and in group-committed batches.
+- --bench-concurrent: random transfers on many threads, then a check that the total money is unchanged.
+- --bench-suite: load / find / add / update / delete ops/sec, p50 / p99 latency and peak RSS as JSON;
+  bank_data_generator.cpp writes deterministic Clients.txt files of 10K to 50M clients for it.
+Every benchmark that changes data works on a copy of the clients file.
+*/
+
+#include "bank_transactions.h"
+
+// ------------------------------------------------------ LOAD BENCHMARK ------------------------------------------------------
+// *****************************************************************************************************************
+
+// Times the loaders on the clients file (and a valid checkpoint of it) and reports their throughput in MB/s
+inline void runLoadBenchmark(string fileName, string delim, int runs, int threads)
+{
+    struct stat info;
+    if (stat(fileName.c_str(), &info) == -1)
+    {
+        cerr << "Error: Could not open file '" << fileName << "' for reading.\n";
+        return;
+    }
+    double megabytes = info.st_size / (1024.0 * 1024.0);
+
+    cout << "Load benchmark: " << fileName << " (" << fixed << setprecision(2) << megabytes << " MB), "
+         << runs << " run(s) each\n";
+
+    auto timeLoader = [&](string name, function<size_t()> loader) // the loader returns the clients it loaded
+    {
+        double bestSeconds = numeric_limits<double>::max();
+        size_t clients = 0;
+        for (int run = 0; run < runs; run++)
+        {
+            auto start = chrono::steady_clock::now();
+            clients = loader();
+            chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+            bestSeconds = min(bestSeconds, elapsed.count());
+        }
+        cout << "- " << left << setw(22) << name << clients << " clients, best " << setprecision(3)
+             << bestSeconds * 1000 << " ms, " << setprecision(1) << megabytes / bestSeconds << " MB/s\n";
+    };
+
+    timeLoader("getline + splitString", [&]()
+               {
+                   vector<sClient> vClients;
+                   readClientsFromFile(fileName, delim, vClients);
+                   return vClients.size(); });
+    timeLoader("mmap + string_view", [&]()
+               {
+                   sClientSlots slots;
+                   readClientsFromMappedFile(fileName, delim, slots);
+                   return slotCount(slots); });
+    if (threads > 1)
+        timeLoader("mmap + " + to_string(threads) + " threads", [&]()
+                   {
+                       sClientSlots slots;
+                       readClientsFromMappedFile(fileName, delim, slots, threads);
+                       return slotCount(slots); });
+
+    sMappedFile checkpoint;
+    sCheckpointHeader header;
+    if (!mapValidCheckpoint(fileName, checkpoint, header))
+        return;
+    unmapFile(checkpoint);
+    timeLoader("checkpoint (mmap)", [&]()
+               {
+                   sClientSlots slots;
+                   sMappedFile mapped;
+                   if (mapValidCheckpoint(fileName, mapped, header))
+                   {
+                       readCheckpointRecords(mapped, header.recordCount, slots, threads);
+                       unmapFile(mapped);
+                   }
+                   return slotCount(slots); });
+}
+
+// --memory-report: loads the clients file into an sClientStore the way the program does and measures what each
+// part of the running store adds to the heap: the client slots (compact records + arena + balances), the columns
+// and the indexes. For comparison it then parses the file once more into a vector of sClient records, the form
+// the store held its clients in before, measures that vector, and checks that every slot expands back to the
+// same client.
+inline void runMemoryReport(string fileName, string delim, int threads)
+{
+    if (!heapStatsAvailable)
+    {
+        cout << "The memory report needs the heap statistics of glibc (mallinfo2), which this system does not have.\n";
+        return;
+    }
+
+    sClientStore store;
+    size_t heapBefore = heapBytesInUse();
+    readClientsFromMappedFile(fileName, delim, store.clients, threads);
+    size_t slotBytes = heapBytesInUse() - heapBefore;
+
+    if (slotCount(store.clients) == 0)
+    {
+        cout << "The memory report needs at least 1 client in '" << fileName << "'.\n";
+        return;
+    }
+
+    size_t heapMark = heapBytesInUse();
+    rebuildAccountIndex(store);
+    size_t indexBytes = heapBytesInUse() - heapMark;
+
+    heapMark = heapBytesInUse();
+    rebuildClientColumns(store);
+    size_t columnBytes = heapBytesInUse() - heapMark;
+
+    heapMark = heapBytesInUse();
+    rebuildSearchIndexes(store);
+    indexBytes += heapBytesInUse() - heapMark;
+    size_t storeBytes = heapBytesInUse() - heapBefore;
+
+    // the same clients as sClient records, one line at a time as the getline loader builds them
+    sMappedFile mapped;
+    if (!mapFile(fileName, mapped))
+    {
+        cerr << "Error: Could not open file '" << fileName << "' for reading.\n";
+        return;
+    }
+    vector<sClient> vClients;
+    heapMark = heapBytesInUse();
+    vClients.reserve(slotCount(store.clients));
+    const char *lineStart = mapped.data, *end = mapped.data + mapped.size;
+    while (lineStart < end)
+    {
+        const char *lineEnd = static_cast<const char *>(memchr(lineStart, '\n', end - lineStart));
+        if (lineEnd == nullptr)
+            lineEnd = end;
+        string_view line(lineStart, lineEnd - lineStart);
+        if (!line.empty() && line.back() == '\r')
+            line.remove_suffix(1);
+
+        sClient client;
+        if (!line.empty() && parseClientLine(line, delim, client))
+            vClients.push_back(move(client));
+        lineStart = lineEnd + 1;
+    }
+    size_t clientBytes = heapBytesInUse() - heapMark;
+    unmapFile(mapped);
+
+    size_t mismatches = (vClients.size() == slotCount(store.clients)) ? 0 : 1;
+    for (size_t slot = 0; mismatches == 0 && slot < vClients.size(); slot++)
+    {
+        sClient expanded = clientAtSlot(store.clients, slot);
+        const sClient &client = vClients[slot];
+        if (expanded.accountNumber != client.accountNumber || expanded.pinCode != client.pinCode ||
+            expanded.fullName != client.fullName || expanded.phone != client.phone || expanded.accountBalance != client.accountBalance)
+            mismatches++;
+    }
+    vector<sClient>().swap(vClients);
+
+    double count = static_cast<double>(slotCount(store.clients));
+    auto line = [&](const string &label, size_t bytes)
+    {
+        cout << "- " << left << setw(36) << label << right << setw(8) << bytes / count << " bytes/client, " << setw(9)
+             << bytes / (1024.0 * 1024.0) << " MB\n";
+    };
+    const sClientArena &arena = store.clients.arena;
+    cout << "Memory report: " << fileName << ", " << slotCount(store.clients) << " clients\n";
+    cout << fixed << setprecision(1);
+    line("client slots (compact records)", slotBytes);
+    line("columns (balances, row / slot maps)", columnBytes);
+    line("indexes (account, prefix, name)", indexBytes);
+    line("whole store", storeBytes);
+    cout << "  A slot is a " << sizeof(sCompactClient) << " B record + 8 B balance + 1 B delete flag + "
+         << static_cast<double>(arena.bytes) / count << " B of text in " << arena.blocks.size() << " arena block(s)\n";
+    line("before: vector<sClient>", clientBytes);
+    cout << "  The clients take " << setprecision(2) << 100.0 * slotBytes / clientBytes << "% of what sClient records took ("
+         << setprecision(1) << slotBytes / count << " vs " << clientBytes / count << " bytes/client)\n";
+    cout << "- round trip: " << (mismatches == 0 ? "every client expands back unchanged" : "slots and sClient records DIFFER!") << "\n";
+}
+
+// *****************************************************************************************************************
+
+// ------------------------------------------------------ TRANSACTION BENCHMARKS ------------------------------------------------------
+// *****************************************************************************************************************
+
+// Copies a file byte for byte (a missing source gives an empty copy)
+inline void copyFile(const string &source, const string &destination)
+{
+    ifstream in(source, ios::binary);
+    ofstream out(destination, ios::binary | ios::trunc);
+    if (in.is_open())
+        out << in.rdbuf();
+}
+
+// --bench-transactions: runs random deposits, withdrawals and transfers on a copy of the clients file,
+// one by one and in batches, and reports transactions per second
+inline void runTransactionBenchmark(string fileName, string delim, sClientStore &settings, size_t count, size_t batchSize)
+{
+    string benchFileName = replaceFileExtension(fileName, ".bench.txt");
+    copyFile(fileName, benchFileName);
+    copyFile(operationLogNameFor(fileName), operationLogNameFor(benchFileName));
+    if (settings.storageFormat == BinaryStorage)
+        copyFile(binaryFileNameFor(fileName), binaryFileNameFor(benchFileName));
+    size_t shardCount = (settings.storageFormat == ShardedStorage) ? readShardManifest(fileName) : 0;
+    if (shardCount > 0)
+        copyFile(shardManifestNameFor(fileName), shardManifestNameFor(benchFileName));
+    for (size_t shard = 0; shard < shardCount; shard++)
+        copyFile(shardFileNameFor(fileName, shard, shardCount), shardFileNameFor(benchFileName, shard, shardCount));
+
+    sClientStore store;
+    store.storageFormat = settings.storageFormat;
+    store.operationLog.fsyncPolicy = settings.operationLog.fsyncPolicy;
+    store.operationLog.compactionThreshold = numeric_limits<size_t>::max(); // keep compaction out of the timings
+    store.loaderThreads = settings.loaderThreads;
+    loadClientStore(benchFileName, delim, store);
+
+    if (store.columns.slotOfRow.size() < 2)
+        cout << "The transaction benchmark needs at least 2 clients in '" << fileName << "'.\n";
+    else
+    {
+        // random transactions between live clients
+        srand(42);
+        vector<sTransaction> vTransactions(count);
+        for (sTransaction &transaction : vTransactions)
+        {
+            const sClientColumns &columns = store.columns;
+            transaction.type = static_cast<enTransactionType>(rand() % 3 + 1);
+            transaction.accountNumber = string(slotAccountNumber(store.clients, columns.slotOfRow[rand() % columns.slotOfRow.size()]));
+            transaction.toAccountNumber = string(slotAccountNumber(store.clients, columns.slotOfRow[rand() % columns.slotOfRow.size()]));
+            transaction.amount = sMoney{rand() % 10000 + 1};
+        }
+
+        cout << "Transaction benchmark: " << count << " transactions on " << store.columns.slotOfRow.size() << " clients\n";
+        cout << fixed << setprecision(0);
+
+        // one commit per transaction (at most 10000 of them, this path is slow by design)
+        size_t singles = min<size_t>(count, 10000);
+        auto start = chrono::steady_clock::now();
+        for (size_t i = 0; i < singles; i++)
+            executeTransaction(benchFileName, delim, store, vTransactions[i]);
+        syncOperationLog(store.operationLog);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cout << "- one commit per transaction : " << singles / seconds << " tx/sec\n";
+
+        // one group commit per batch
+        sBatchResult total;
+        for (size_t first = 0; first < count; first += batchSize)
+        {
+            vector<sTransaction> vBatch(vTransactions.begin() + first, vTransactions.begin() + min(count, first + batchSize));
+            sBatchResult batch = executeTransactionBatch(benchFileName, delim, store, vBatch);
+            total.done += batch.done;
+            total.rejected += batch.rejected;
+            total.seconds += batch.seconds;
+        }
+        cout << "- one group commit per batch : " << count / total.seconds << " tx/sec (batches of " << batchSize << ", " << total.done << " done, "
+             << total.rejected << " rejected)\n";
+    }
+
+    remove(benchFileName.c_str());
+    remove(operationLogNameFor(benchFileName).c_str());
+    remove(binaryFileNameFor(benchFileName).c_str());
+    remove(shardManifestNameFor(benchFileName).c_str());
+    removeShardFiles(benchFileName, shardCount);
+}
+
+// Runs 'count' random transfers between live clients on 'threads' threads; returns the elapsed seconds
+inline double runConcurrentTransfers(sConcurrentAccounts &accounts, size_t count, int threads, size_t &done)
+{
+    const vector<int> &slotOfRow = accounts.store->columns.slotOfRow;
+    vector<size_t> doneByThread(threads, 0);
+    vector<thread> workers;
+
+    auto start = chrono::steady_clock::now();
+    for (int t = 0; t < threads; t++)
+    {
+        workers.emplace_back([&, t]()
+                             {
+                                 mt19937_64 random(42 + t);
+                                 uniform_int_distribution<size_t> pickRow(0, slotOfRow.size() - 1);
+                                 uniform_int_distribution<int> pickCents(1, 10000);
+                                 size_t share = count / threads + (static_cast<size_t>(t) < count % threads ? 1 : 0);
+                                 for (size_t i = 0; i < share; i++)
+                                 {
+                                     int fromSlot = slotOfRow[pickRow(random)];
+                                     int toSlot = slotOfRow[pickRow(random)];
+                                     if (executeConcurrentTransactionOnSlots("", "", accounts, Transfer, fromSlot, toSlot,
+                                                                             sMoney{pickCents(random)}, false) == TransactionDone)
+                                         doneByThread[t]++;
+                                 } });
+    }
+    for (thread &worker : workers)
+        worker.join();
+
+    done = 0;
+    for (size_t d : doneByThread)
+        done += d;
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// --bench-concurrent: random transfers on 'threads' threads, first under one lock for all accounts and then
+// with striped locks; after each run the total money must be exactly what it was. Memory only, nothing is written.
+inline void runConcurrentTransferBenchmark(string fileName, string delim, sClientStore &store, size_t count, int threads, size_t stripeCount)
+{
+    loadClientStore(fileName, delim, store);
+    if (store.columns.slotOfRow.size() < 2)
+    {
+        cout << "The concurrent benchmark needs at least 2 clients in '" << fileName << "'.\n";
+        return;
+    }
+
+    cout << "Concurrent transfer benchmark: " << count << " transfers on " << store.columns.slotOfRow.size() << " clients, "
+         << threads << " thread(s)\n";
+
+    sMoney totalBefore = totalBalance(store);
+    bool totalsMatch = true;
+    for (size_t stripes : {size_t(1), stripeCount})
+    {
+        sConcurrentAccounts accounts;
+        initConcurrentAccounts(accounts, store, stripes);
+
+        size_t done = 0;
+        double seconds = runConcurrentTransfers(accounts, count, threads, done);
+        sMoney totalAfter = totalBalance(store);
+        totalsMatch = totalsMatch && (totalAfter == totalBefore);
+
+        cout << "- " << setw(5) << stripes << (stripes == 1 ? " lock   : " : " stripes: ") << fixed << setprecision(0) << count / seconds
+             << " transfers/sec (" << done << " done, " << count - done << " rejected), total money "
+             << (totalAfter == totalBefore ? "unchanged" : "CHANGED") << "\n";
+    }
+
+    cout << "Total money: " << totalBefore << (totalsMatch ? " (verified)\n" : " (MISMATCH!)\n");
+}
+
+// *****************************************************************************************************************
+
+// ------------------------------------------------------ BENCHMARK SUITE ------------------------------------------------------
+// ********************************************************************************************************************************
+// --bench-suite[=OPS] times the store operations on a copy of the clients file (bank_data_generator.cpp writes
+// files of 10K to 50M clients) and prints one JSON document for regression tracking:
+//   load       readClientsFromFile, the whole file per op
+//   find       findClientInFileByAccountNum on a loaded store, and through Clients.idx before anything is loaded
+//   add        addClientToStore + saveNewClients (what AddNewClient does once the prompts are answered)
+//   update     updateClientRecord (updateClientInFileByAccountNumber without its prompts)
+//   delete     deleteClientByAccNum (removeClientFromFileByAccNum without its prompts)
+// Account numbers are picked with a fixed seed, so two runs on the same file do the same operations.
+// Peak RSS is the process high-water mark after each phase, so it only ever grows.
+
+const int suiteLoadRuns = 3;
+
+struct sBenchmarkPhase
+{
+    string name;
+    string function;
+    vector<double> latencies; // microseconds, one per operation
+    double seconds = 0;
+    long peakRssKb = 0;
+};
+
+inline double latencyPercentile(vector<double> &latencies, double p)
+{
+    if (latencies.empty())
+        return 0;
+    size_t k = min(latencies.size() - 1, static_cast<size_t>(p * latencies.size()));
+    nth_element(latencies.begin(), latencies.begin() + k, latencies.end());
+    return latencies[k];
+}
+
+// Runs operation(0 .. count-1), timing each one
+inline sBenchmarkPhase timeBenchmarkPhase(string name, string timedFunction, size_t count, function<void(size_t)> operation)
+{
+    sBenchmarkPhase phase;
+    phase.name = name;
+    phase.function = timedFunction;
+    phase.latencies.reserve(count);
+
+    auto phaseStart = chrono::steady_clock::now();
+    for (size_t i = 0; i < count; i++)
+    {
+        auto start = chrono::steady_clock::now();
+        operation(i);
+        phase.latencies.push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - start).count());
+    }
+    phase.seconds = chrono::duration<double>(chrono::steady_clock::now() - phaseStart).count();
+    phase.peakRssKb = peakRssKb();
+    return phase;
+}
+
+// 'count' different live account numbers, in a random but repeatable order
+inline vector<string> pickBenchmarkAccounts(const sClientStore &store, size_t count, mt19937_64 &random)
+{
+    const sClientColumns &columns = store.columns;
+    size_t rows = columns.slotOfRow.size();
+    count = min(count, rows);
+
+    vector<string> vAccounts;
+    vAccounts.reserve(count);
+    unordered_map<size_t, bool> picked;
+    while (vAccounts.size() < count)
+    {
+        size_t row = random() % rows;
+        if (picked.emplace(row, true).second)
+            vAccounts.emplace_back(slotAccountNumber(store.clients, columns.slotOfRow[row]));
+    }
+    return vAccounts;
+}
+
+inline void printBenchmarkPhaseJson(sBenchmarkPhase &phase, bool last)
+{
+    size_t ops = phase.latencies.size();
+    cout << "    {\"name\": \"" << phase.name << "\", \"function\": \"" << phase.function << "\", \"ops\": " << ops
+         << ", \"seconds\": " << setprecision(6) << phase.seconds
+         << ", \"ops_per_sec\": " << setprecision(1) << (phase.seconds > 0 ? ops / phase.seconds : 0.0)
+         << ", \"p50_us\": " << setprecision(2) << latencyPercentile(phase.latencies, 0.50)
+         << ", \"p99_us\": " << latencyPercentile(phase.latencies, 0.99)
+         << ", \"peak_rss_kb\": " << phase.peakRssKb << "}" << (last ? "\n" : ",\n");
+}
+
+// --bench-suite: runs every phase on a copy of the clients file and prints the results as JSON
+inline void runBenchmarkSuite(string fileName, string delim, sClientStore &settings, size_t count)
+{
+    struct stat info;
+    if (stat(fileName.c_str(), &info) == -1)
+    {
+        cerr << "Error: Could not open file '" << fileName << "' for reading.\n";
+        return;
+    }
+
+    string benchFileName = replaceFileExtension(fileName, ".suite.txt");
+    copyFile(fileName, benchFileName);
+    copyFile(operationLogNameFor(fileName), operationLogNameFor(benchFileName));
+
+    auto newBenchStore = [&](sClientStore &store)
+    {
+        store.operationLog.fsyncPolicy = settings.operationLog.fsyncPolicy;
+        store.operationLog.compactionThreshold = settings.operationLog.compactionThreshold;
+        store.loaderThreads = settings.loaderThreads;
+        store.checkpoint.everyChanges = 0; // checkpoints are not part of any phase
+    };
+
+    vector<sBenchmarkPhase> vPhases;
+    vector<sClient> vLoaded;
+    vPhases.push_back(timeBenchmarkPhase("load", "readClientsFromFile", suiteLoadRuns, [&](size_t)
+                                         { readClientsFromFile(benchFileName, delim, vLoaded); }));
+    size_t clients = vLoaded.size();
+    vector<sClient>().swap(vLoaded);
+
+    sClientStore store;
+    newBenchStore(store);
+    loadClientStore(benchFileName, delim, store);
+
+    mt19937_64 random(42);
+    vector<string> vAccounts = pickBenchmarkAccounts(store, count, random);
+    sClient found;
+
+    vPhases.push_back(timeBenchmarkPhase("find", "findClientInFileByAccountNum", vAccounts.size(), [&](size_t i)
+                                         { findClientInFileByAccountNum(benchFileName, delim, vAccounts[i], store, found); }));
+
+    {
+        // a store that never loaded answers from Clients.idx, which is built first (untimed)
+        sClientStore indexedStore;
+        newBenchStore(indexedStore);
+        openClientIndexFile(benchFileName, delim, indexedStore);
+        vPhases.push_back(timeBenchmarkPhase("find_indexed", "findClientInFileByAccountNum (Clients.idx)", vAccounts.size(), [&](size_t i)
+                                             { findClientInFileByAccountNum(benchFileName, delim, vAccounts[i], indexedStore, found); }));
+    }
+
+    vPhases.push_back(timeBenchmarkPhase("add", "AddNewClient (saveNewClients)", count, [&](size_t i)
+                                         {
+                                             sClient client;
+                                             client.accountNumber = "BENCH" + to_string(i);
+                                             client.pinCode = "1234";
+                                             client.fullName = "Benchmark Client " + to_string(i);
+                                             client.phone = "01000000000";
+                                             client.accountBalance = sMoney{static_cast<long long>(i % 100000)};
+                                             vector<sClient> vNewClients = {client};
+                                             addClientToStore(store, client);
+                                             saveNewClients(benchFileName, delim, vNewClients, store); }));
+
+    vPhases.push_back(timeBenchmarkPhase("update", "updateClientInFileByAccountNumber (updateClientRecord)", vAccounts.size(), [&](size_t i)
+                                         {
+                                             sClient client = clientAtSlot(store.clients, findClientSlot(store, vAccounts[i]));
+                                             client.accountBalance += sMoney{100};
+                                             updateClientRecord(benchFileName, delim, client, store); }));
+
+    vPhases.push_back(timeBenchmarkPhase("delete", "removeClientFromFileByAccNum (deleteClientByAccNum)", vAccounts.size(), [&](size_t i)
+                                         { deleteClientByAccNum(benchFileName, delim, vAccounts[i], store); }));
+
+    syncOperationLog(store.operationLog);
+    waitForClientsFileRewrites(store.fileFlusher);
+
+    const char *fsyncNames[] = {"", "every", "group", "none"};
+    cout << fixed;
+    cout << "{\n";
+    cout << "  \"benchmark\": \"bank_system --bench-suite\",\n";
+    cout << "  \"file\": \"" << fileName << "\",\n";
+    cout << "  \"file_bytes\": " << info.st_size << ",\n";
+    cout << "  \"clients\": " << clients << ",\n";
+    cout << "  \"ops_per_phase\": " << count << ",\n";
+    cout << "  \"fsync\": \"" << fsyncNames[settings.operationLog.fsyncPolicy] << "\",\n";
+    cout << "  \"threads\": " << settings.loaderThreads << ",\n";
+    cout << "  \"phases\": [\n";
+    for (size_t i = 0; i < vPhases.size(); i++)
+        printBenchmarkPhaseJson(vPhases[i], i + 1 == vPhases.size());
+    cout << "  ]\n";
+    cout << "}\n";
+
+    remove(benchFileName.c_str());
+    remove(operationLogNameFor(benchFileName).c_str());
+    remove(retiredLogNameFor(benchFileName).c_str());
+    remove(indexFileNameFor(benchFileName).c_str());
+}
+
+// ********************************************************************************************************************************
+
+#endif
@@ -0,0 +1,101 @@
+#include <sys/wait.h>
+#include "bank_storage.h"
+
+using namespace std;
+/*
+=======================================
+Bank Crash-Safe Rewrite Test
+=======================================
+
+Checks that a clients file rewritten through the background flusher (bank_storage.h) is always a complete
+old or new version, however the writer dies:
+- A child process keeps rewriting a scratch file with ever newer versions (20000 client lines each, so a
+  kill often lands in the middle of writing one) and is killed with SIGKILL after a random delay.
+- The file must then hold the version from before the child started or one of the versions it wrote,
+  never a mix of two or a partial one.
+
+Exits with 1 if any round left a broken file, 0 otherwise.
+
+Usage: bank_crash_test [ROUNDS=100] [FILE=Clients.crashtest.txt]
+Build: g++ -std=c++17 -O2 -pthread bank_crash_test.cpp -o bank_crash_test
+*/
+
+const string delim = "#||#";
+
+// Contents of a test version: enough lines that a kill often lands in the middle of writing them
+string crashTestContents(size_t version)
+{
+    string contents;
+    for (int i = 0; i < 20000; i++)
+        contents += "AC" + to_string(10000000 + i) + delim + "1234" + delim + "Crash Test Version " + to_string(version) + delim +
+                    "01000000000" + delim + to_string(version) + ".00\n";
+    return contents;
+}
+
+// Version held by a test file, or 0 if it is not exactly one complete version
+size_t crashTestVersionOf(const string &fileName)
+{
+    ifstream file(fileName, ios::binary);
+    string contents((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+    size_t marker = contents.find("Crash Test Version ");
+    if (marker == string::npos)
+        return 0;
+
+    size_t version = strtoull(contents.c_str() + marker + 19, nullptr, 10);
+    return (contents == crashTestContents(version)) ? version : 0;
+}
+
+int main(int argc, char *argv[])
+{
+    int rounds = argc > 1 ? max(1, stoi(argv[1])) : 100;
+    string testFileName = argc > 2 ? argv[2] : "Clients.crashtest.txt";
+
+    size_t lastVersion = 1;
+    if (!writeFileAtomically(testFileName, crashTestContents(lastVersion)))
+    {
+        cerr << "Error: Could not write file '" << testFileName << "'.\n";
+        return 1;
+    }
+
+    mt19937 random(42);
+    uniform_int_distribution<int> pickDelayMicroseconds(0, 30000);
+    int keptOld = 0, gotNew = 0, broken = 0;
+
+    cout << "Crash test: " << rounds << " round(s) on '" << testFileName << "'\n";
+    for (int round = 0; round < rounds; round++)
+    {
+        pid_t child = fork();
+        if (child == -1)
+        {
+            cerr << "Error: Could not start the writer process.\n";
+            return 1;
+        }
+        if (child == 0)
+        {
+            sClientsFileFlusher flusher;
+            for (size_t version = lastVersion + 1;; version++)
+                requestClientsFileRewrite(flusher, testFileName, crashTestContents(version));
+        }
+
+        usleep(pickDelayMicroseconds(random));
+        kill(child, SIGKILL);
+        waitpid(child, nullptr, 0);
+
+        size_t version = crashTestVersionOf(testFileName);
+        if (version == 0 || version < lastVersion)
+        {
+            broken++;
+            cout << "- round " << round + 1 << ": the file is neither the old nor a new version!\n";
+            continue;
+        }
+        (version == lastVersion ? keptOld : gotNew)++;
+        lastVersion = version;
+    }
+
+    cout << "- old version kept: " << keptOld << ", new version in place: " << gotNew << ", broken: " << broken << "\n";
+    cout << (broken == 0 ? "Every kill left a complete file.\n" : "FAILED: some kills left a broken file.\n");
+    remove(testFileName.c_str());
+    remove(temporaryFileNameFor(testFileName).c_str());
+
+    return broken == 0 ? 0 : 1;
+}
@@ -0,0 +1,199 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <charconv>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+/*
+=======================================
+Bank Client Data Generator
+=======================================
+
+Writes a Clients.txt of N synthetic clients that pass every validation rule of bank_system, for
+benchmarks from 10K to 50M clients (`bank_system --bench-suite` runs on the file it finds).
+
+- Deterministic: client i depends only on (SEED, i), so the same arguments give the same bytes on
+  any machine (only the raw 64-bit splitmix generator is used, no library distributions).
+- Account numbers: a 2-letter branch code and 8 to 12 digits; the digits are a permutation of i,
+  so they are unique but not in file order.
+- Names: first + last name (30% with a middle name, 10% with a double last name), 8 to ~40 characters.
+- PIN: 4 digits. Phone: "01" + operator digit (0, 1, 2 or 5) + 8 digits.
+- Balance: 5% zero, the rest log-normal around ~3,000 with a long tail, in whole cents.
+
+Usage: bank_data_generator [CLIENTS=100000] [FILE=Clients.txt] [SEED=1]
+Build: g++ -std=c++17 -O2 bank_data_generator.cpp -o bank_data_generator
+*/
+
+const string delim = "#||#";
+const uint64_t accountDigitsRange = 100000000; // 8 digits: enough distinct account numbers for 50M clients
+const uint64_t accountPermutation = 73939133;  // odd and not a multiple of 5, so i * it mod 10^8 is a permutation
+const size_t writeBufferBytes = 4 * 1024 * 1024;
+
+const char *branchCodes[] = {"AC", "EG", "CA", "AL", "GZ", "MN"};
+const char *firstNames[] = {"Ahmed", "Mohamed", "Mahmoud", "Omar", "Ali", "Youssef", "Mostafa", "Khaled", "Hassan", "Ibrahim",
+                            "Abdelrahman", "Karim", "Tarek", "Amr", "Mina", "Fatma", "Mariam", "Nour", "Salma", "Aya",
+                            "Hana", "Yasmin", "Sara", "Reem", "Dina", "Laila", "Habiba", "Rana", "Shaimaa", "Marwa"};
+const char *lastNames[] = {"Belal", "Hassan", "Mahmoud", "Ibrahim", "Abdelaziz", "El-Sayed", "Mostafa", "Farouk", "Gamal", "Ragab",
+                           "Soliman", "Abdelmoneim", "Shehata", "Hegazy", "Nasser", "Zaki", "Fawzy", "El-Masry", "Younes", "Lotfy",
+                           "Kamel", "Abdelhamid", "Osman", "Rizk", "Saad", "Badawi", "Ezzat", "Helmy", "Morsi", "Taha"};
+const char operatorDigits[] = {'0', '1', '2', '5'};
+
+// splitmix64: the state of client i is seeded from (seed, i) alone
+uint64_t nextRandom(uint64_t &state)
+{
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// Uniform in [0, 1)
+double nextUnit(uint64_t &state)
+{
+    return (nextRandom(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+template <typename T, size_t N>
+const T &pick(const T (&values)[N], uint64_t &state)
+{
+    return values[nextRandom(state) % N];
+}
+
+void appendDigits(string &line, uint64_t value, int digits)
+{
+    char text[24];
+    for (int i = digits - 1; i >= 0; i--)
+    {
+        text[i] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+    line.append(text, digits);
+}
+
+// Log-normal balance in cents (Box-Muller for the normal draw), 5% of accounts empty
+long long randomBalanceInCents(uint64_t &state)
+{
+    if (nextRandom(state) % 100 < 5)
+        return 0;
+
+    double u1 = max(nextUnit(state), 1e-12);
+    double u2 = nextUnit(state);
+    double normal = sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+    double units = exp(8.0 + 1.6 * normal); // median ~3,000, p99 ~125,000
+    return min(static_cast<long long>(units * 100.0), 99999999999LL);
+}
+
+// Appends the line of client 'i' (no newline)
+void appendClientLine(string &line, uint64_t seed, uint64_t i)
+{
+    uint64_t state = seed * 0xD1B54A32D192ED03ULL + i;
+
+    // account number: branch code + 8..12 digits, the 8 low ones a permutation of i
+    int extraDigits = static_cast<int>(nextRandom(state) % 5);
+    line.append(pick(branchCodes, state));
+    appendDigits(line, nextRandom(state), extraDigits);
+    appendDigits(line, (i % accountDigitsRange) * accountPermutation % accountDigitsRange, 8);
+    line.append(delim);
+
+    appendDigits(line, nextRandom(state) % 10000, 4);
+    line.append(delim);
+
+    line.append(pick(firstNames, state));
+    if (nextRandom(state) % 100 < 30)
+        line.append(" ").append(pick(firstNames, state));
+    line.append(" ").append(pick(lastNames, state));
+    if (nextRandom(state) % 100 < 10)
+        line.append(" ").append(pick(lastNames, state));
+    line.append(delim);
+
+    line.append("01");
+    line += pick(operatorDigits, state);
+    appendDigits(line, nextRandom(state) % 100000000, 8);
+    line.append(delim);
+
+    long long cents = randomBalanceInCents(state);
+    char balance[32];
+    char *end = to_chars(balance, balance + sizeof(balance), cents / 100).ptr;
+    *end++ = '.';
+    *end++ = static_cast<char>('0' + cents % 100 / 10);
+    *end++ = static_cast<char>('0' + cents % 10);
+    line.append(balance, end);
+}
+
+bool writeAll(int fd, const string &buffer)
+{
+    size_t written = 0;
+    while (written < buffer.size())
+    {
+        ssize_t n = write(fd, buffer.data() + written, buffer.size() - written);
+        if (n <= 0)
+            return false;
+        written += n;
+    }
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    uint64_t clients = argc > 1 ? stoull(argv[1]) : 100000;
+    string fileName = argc > 2 ? argv[2] : "Clients.txt";
+    uint64_t seed = argc > 3 ? stoull(argv[3]) : 1;
+
+    if (clients > accountDigitsRange)
+    {
+        cerr << "Error: At most " << accountDigitsRange << " clients can be generated.\n";
+        return 1;
+    }
+
+    int fd = open(fileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1)
+    {
+        cerr << "Error: Could not open file '" << fileName << "' for writing.\n";
+        return 1;
+    }
+
+    auto start = chrono::steady_clock::now();
+    string buffer;
+    buffer.reserve(writeBufferBytes + 256);
+    uint64_t bytes = 0;
+    bool ok = true;
+    for (uint64_t i = 0; ok && i < clients; i++)
+    {
+        appendClientLine(buffer, seed, i);
+        buffer += '\n';
+        if (buffer.size() >= writeBufferBytes)
+        {
+            bytes += buffer.size();
+            ok = writeAll(fd, buffer);
+            buffer.clear();
+        }
+    }
+    bytes += buffer.size();
+    ok = ok && writeAll(fd, buffer) && fsync(fd) == 0;
+    close(fd);
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+    if (!ok)
+    {
+        cerr << "Error: Could not write '" << fileName << "'.\n";
+        return 1;
+    }
+
+    cout << fixed << setprecision(1);
+    cout << "Wrote " << clients << " clients (" << bytes / (1024.0 * 1024.0) << " MB) to '" << fileName << "' in "
+         << elapsed.count() << " s, seed " << seed << "\n";
+
+    // a log (or index / checkpoint) left from an older file would be replayed on top of this one
+    string base = fileName.substr(0, fileName.rfind('.'));
+    if (access((base + ".log").c_str(), F_OK) == 0)
+        cout << "Note: '" << base << ".log' belongs to the previous file; remove it (and " << base << ".idx / "
+             << base << ".ckpt) before loading.\n";
+    return 0;
+}
@@ -0,0 +1,380 @@
+#ifndef BANK_IMPORT_H
+#define BANK_IMPORT_H
+
+/*
+=======================================
+Bank bulk import — streaming a large client file into the store
+=======================================
+
+--import=FILE runs read -> validate -> dedupe -> append as a pipeline joined by bounded queues, with the
+validation spread over worker threads. Invalid or duplicate rows go to FILE.rejects with the reason.
+*/
+
+#include "bank_storage.h"
+
+// ------------------------------------------------------ BULK IMPORT ------------------------------------------------------
+// *****************************************************************************************************************
+// --import=FILE streams a delimited client file into the store through stages joined by bounded queues:
+//   read (1 thread, ~1 MB blocks cut at line ends) -> split + validate (--threads workers)
+//   -> dedupe + append (1 thread, in input order)
+// A full queue blocks the stage in front of it, so memory stays bounded however large the file is.
+// Validation uses the same rules as the prompts; rows that fail it, or repeat an account that already
+// exists, go to "<file>.rejects" as "<line>#||#<reason>#||#<original line>".
+
+const size_t importBlockBytes = 1024 * 1024;
+const size_t importQueueCapacity = 8; // blocks / batches in flight between two stages
+
+template <typename T>
+struct sBoundedQueue
+{
+    mutex lock;
+    condition_variable notEmpty;
+    condition_variable notFull;
+    deque<T> items;
+    size_t capacity = importQueueCapacity;
+    bool closed = false;
+};
+
+// Blocks while the queue is full
+template <typename T>
+void pushToQueue(sBoundedQueue<T> &queue, T item)
+{
+    unique_lock<mutex> guard(queue.lock);
+    queue.notFull.wait(guard, [&]()
+                       { return queue.items.size() < queue.capacity; });
+    queue.items.push_back(move(item));
+    queue.notEmpty.notify_one();
+}
+
+// Blocks while the queue is empty; returns false once it is closed and drained
+template <typename T>
+bool popFromQueue(sBoundedQueue<T> &queue, T &item)
+{
+    unique_lock<mutex> guard(queue.lock);
+    queue.notEmpty.wait(guard, [&]()
+                        { return !queue.items.empty() || queue.closed; });
+    if (queue.items.empty())
+        return false;
+    item = move(queue.items.front());
+    queue.items.pop_front();
+    queue.notFull.notify_one();
+    return true;
+}
+
+template <typename T>
+void closeQueue(sBoundedQueue<T> &queue)
+{
+    lock_guard<mutex> guard(queue.lock);
+    queue.closed = true;
+    queue.notEmpty.notify_all();
+}
+
+struct sImportBlock
+{
+    size_t sequence = 0;
+    size_t firstLine = 0; // 1-based line number of the block's first line
+    string text;          // whole lines only
+};
+
+struct sImportRow
+{
+    size_t line;
+    sClient client;
+    size_t textStart;  // the line as read (without '\r'), in the batch's text, for the reject file
+    size_t textLength;
+};
+
+struct sImportReject
+{
+    size_t line;
+    string reason;
+    string text;
+};
+
+struct sImportBatch
+{
+    size_t sequence = 0;
+    string text;                   // the block the rows were read from
+    vector<sImportRow> rows;       // valid rows, in line order
+    vector<sImportReject> rejects; // invalid rows, in line order
+};
+
+struct sImportStats
+{
+    size_t rows = 0;
+    size_t imported = 0;
+    size_t invalid = 0;
+    size_t duplicates = 0;
+    size_t bytes = 0;
+};
+
+// Stage 1: reads the file in blocks that end at a line end
+inline void readImportBlocks(const string &importFileName, sBoundedQueue<sImportBlock> &blocks, size_t &bytes)
+{
+    ifstream input(importFileName, ios::binary);
+    string carry;
+    size_t sequence = 0, nextLine = 1;
+    vector<char> buffer(importBlockBytes);
+
+    while (input)
+    {
+        input.read(buffer.data(), buffer.size());
+        size_t got = input.gcount();
+        if (got == 0)
+            break;
+        bytes += got;
+
+        sImportBlock block;
+        block.sequence = sequence++;
+        block.firstLine = nextLine;
+        block.text.swap(carry);
+        block.text.append(buffer.data(), got);
+
+        // keep an unfinished last line for the next block (the final block takes whatever is left)
+        size_t lastNewline = block.text.rfind('\n');
+        if (input && lastNewline != string::npos)
+        {
+            carry.assign(block.text, lastNewline + 1, string::npos);
+            block.text.resize(lastNewline + 1);
+        }
+        else if (input)
+        {
+            carry.swap(block.text); // a line longer than a block
+            sequence--;
+            continue;
+        }
+
+        nextLine += count(block.text.begin(), block.text.end(), '\n');
+        pushToQueue(blocks, move(block));
+    }
+
+    if (!carry.empty())
+    {
+        sImportBlock block;
+        block.sequence = sequence++;
+        block.firstLine = nextLine;
+        block.text.swap(carry);
+        pushToQueue(blocks, move(block));
+    }
+    closeQueue(blocks);
+}
+
+// Stage 2: splits blocks into lines and validates every field
+inline void validateImportBlocks(sBoundedQueue<sImportBlock> &blocks, sBoundedQueue<sImportBatch> &batches, string delim,
+                          atomic<int> &runningValidators)
+{
+    sImportBlock block;
+    while (popFromQueue(blocks, block))
+    {
+        sImportBatch batch;
+        batch.sequence = block.sequence;
+
+        size_t line = block.firstLine;
+        size_t start = 0;
+        while (start < block.text.size())
+        {
+            size_t end = block.text.find('\n', start);
+            if (end == string::npos)
+                end = block.text.size();
+            string_view text(block.text.data() + start, end - start);
+            if (!text.empty() && text.back() == '\r')
+                text.remove_suffix(1);
+
+            if (!text.empty())
+            {
+                sImportRow row;
+                string error;
+                if (parseValidClientLine(text, delim, row.client, error))
+                {
+                    row.line = line;
+                    row.textStart = start;
+                    row.textLength = text.size();
+                    batch.rows.push_back(move(row));
+                }
+                else
+                    batch.rejects.push_back({line, error, string(text)});
+            }
+            start = end + 1;
+            line++;
+        }
+        batch.text.swap(block.text);
+        pushToQueue(batches, move(batch));
+    }
+
+    if (--runningValidators == 0)
+        closeQueue(batches);
+}
+
+inline void writeImportReject(ofstream &rejectFile, const sImportReject &reject, const string &delim)
+{
+    rejectFile << reject.line << delim << reject.reason << delim << reject.text << "\n";
+}
+
+// Stage 3 helper: writes the imported clients in slots [first, end) to the storage
+// ('textFds': Clients.txt, or one descriptor per shard file)
+inline bool persistImportedClients(string delim, sClientStore &store, size_t first, const vector<int> &textFds)
+{
+    if (first == slotCount(store.clients))
+        return true;
+
+    if (store.storageFormat == BinaryStorage)
+    {
+        vector<sBinaryClientRecord> records(slotCount(store.clients) - first);
+        for (size_t i = 0; i < records.size(); i++)
+            packSlotRecord(store.clients, first + i, records[i]);
+        if (!pwriteAll(store.binaryStorage.fd, records.data(), records.size() * sizeof(sBinaryClientRecord), binaryRecordOffset(first)))
+            return false;
+
+        store.binaryStorage.recordCount = slotCount(store.clients);
+        uint64_t count = store.binaryStorage.recordCount;
+        return pwriteAll(store.binaryStorage.fd, &count, sizeof(count), offsetof(sBinaryFileHeader, recordCount));
+    }
+
+    vector<string> buffers(textFds.size());
+    for (size_t slot = first; slot < slotCount(store.clients); slot++)
+    {
+        string &buffer = buffers[(textFds.size() == 1) ? 0 : shardOfAccount(store.shards, slotAccountNumber(store.clients, slot))];
+        appendSlotAsLine(buffer, store.clients, slot, delim);
+        buffer += '\n';
+    }
+    for (size_t i = 0; i < textFds.size(); i++)
+    {
+        size_t written = 0;
+        while (written < buffers[i].size())
+        {
+            ssize_t n = write(textFds[i], buffers[i].data() + written, buffers[i].size() - written);
+            if (n <= 0)
+                return false;
+            written += n;
+        }
+    }
+    return true;
+}
+
+// --import: runs the pipeline and reports rows/sec
+inline void runBulkImport(string fileName, string delim, sClientStore &store, const string &importFileName)
+{
+    if (!ifstream(importFileName).is_open())
+    {
+        cerr << "Error: Could not open file '" << importFileName << "' for reading.\n";
+        return;
+    }
+
+    loadClientStore(fileName, delim, store);
+
+    // Imported rows are appended to the base file (or to the shard file of each row). The log is folded in
+    // first, so that no older DELETE record in it can be replayed over a client imported under the same account number.
+    vector<int> textFds;
+    if (store.storageFormat == BinaryStorage)
+    {
+        if (!openBinaryStorage(store.binaryStorage, fileName))
+            return;
+    }
+    else
+    {
+        if (openOperationLog(store.operationLog, fileName) && store.operationLog.bytes > 0)
+            compactOperationLog(fileName, delim, store);
+        waitForClientsFileRewrites(store.fileFlusher); // appending to a file about to be replaced would be lost
+
+        vector<string> textFileNames = {fileName};
+        if (store.storageFormat == ShardedStorage)
+        {
+            textFileNames.clear();
+            for (size_t shard = 0; shard < store.shards.shardCount; shard++)
+                textFileNames.push_back(shardFileNameFor(fileName, shard, store.shards.shardCount));
+        }
+        for (const string &textFileName : textFileNames)
+        {
+            int fd = open(textFileName.c_str(), O_WRONLY | O_APPEND | O_CREAT, 0644);
+            if (fd == -1)
+            {
+                cerr << "Error: Could not open file '" << textFileName << "' for writing.\n";
+                for (int opened : textFds)
+                    close(opened);
+                return;
+            }
+            textFds.push_back(fd);
+        }
+    }
+
+    string rejectFileName = importFileName + ".rejects";
+    ofstream rejectFile(rejectFileName, ios::trunc);
+
+    auto start = chrono::steady_clock::now();
+    sBoundedQueue<sImportBlock> blocks;
+    sBoundedQueue<sImportBatch> batches;
+    sImportStats stats;
+    int validators = max(1, store.loaderThreads);
+    atomic<int> runningValidators(validators);
+
+    thread reader(readImportBlocks, cref(importFileName), ref(blocks), ref(stats.bytes));
+    vector<thread> workers;
+    for (int i = 0; i < validators; i++)
+        workers.emplace_back(validateImportBlocks, ref(blocks), ref(batches), delim, ref(runningValidators));
+
+    // Stage 3: batches arrive in any order; they are applied in input order, so the first row
+    // with an account number wins and later ones are rejected as duplicates
+    map<size_t, sImportBatch> waiting;
+    size_t nextSequence = 0;
+    sImportBatch batch;
+    bool ok = true;
+    while (popFromQueue(batches, batch))
+    {
+        waiting[batch.sequence] = move(batch);
+        for (auto next = waiting.find(nextSequence); next != waiting.end(); next = waiting.find(++nextSequence))
+        {
+            sImportBatch &ready = next->second;
+            size_t firstNewSlot = slotCount(store.clients);
+            size_t r = 0;
+            for (sImportRow &row : ready.rows)
+            {
+                // rejects of this batch that come before the row, to keep the reject file in line order
+                for (; r < ready.rejects.size() && ready.rejects[r].line < row.line; r++)
+                    writeImportReject(rejectFile, ready.rejects[r], delim);
+
+                if (isAccountNumberExist(row.client.accountNumber, store))
+                {
+                    writeImportReject(rejectFile, {row.line, "Account number already exists.", ready.text.substr(row.textStart, row.textLength)}, delim);
+                    stats.duplicates++;
+                    continue;
+                }
+                addClientToStoreDeferringSearchIndexes(store, row.client);
+                stats.imported++;
+            }
+            for (; r < ready.rejects.size(); r++)
+                writeImportReject(rejectFile, ready.rejects[r], delim);
+
+            stats.invalid += ready.rejects.size();
+            stats.rows += ready.rows.size() + ready.rejects.size();
+            ok = ok && persistImportedClients(delim, store, firstNewSlot, textFds);
+            waiting.erase(next);
+        }
+    }
+
+    reader.join();
+    for (thread &worker : workers)
+        worker.join();
+
+    for (int fd : textFds)
+    {
+        fsync(fd);
+        close(fd);
+    }
+    if (textFds.empty() && store.operationLog.fsyncPolicy != FsyncNone)
+        syncFileData(store.binaryStorage.fd);
+    rebuildSearchIndexes(store);
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    if (!ok)
+        cerr << "Error: Could not write the imported clients to the storage.\n";
+    cout << "Imported " << stats.imported << " of " << stats.rows << " row(s) from '" << importFileName << "' ("
+         << stats.invalid << " invalid, " << stats.duplicates << " duplicate(s)) in " << fixed << setprecision(2) << seconds << " s\n";
+    cout << setprecision(0) << stats.rows / seconds << " rows/sec, " << setprecision(1) << stats.bytes / (1024.0 * 1024.0) / seconds
+         << " MB/s with " << validators << " validation thread(s)\n";
+    if (stats.invalid + stats.duplicates > 0)
+        cout << "Rejected rows and reasons: '" << rejectFileName << "'\n";
+}
+
+// *****************************************************************************************************************
+
+#endif
@@ -0,0 +1,811 @@
+#ifndef BANK_INDEXES_H
+#define BANK_INDEXES_H
+
+/*
+=======================================
+Bank store indexes — in-memory lookups over the client slots
+=======================================
+
+- Account index: open-addressing hash from account number to slot, O(1) lookups kept in sync by add,
+  update and delete.
+- Columnar copy: every live balance in one contiguous array, for the SIMD balance reports.
+- Prefix indexes: phone and account-number keys in sorted order plus a small unsorted tail, so a prefix
+  returns its first K matches in O(log n + K).
+- Name index: a trigram inverted index over full names with compressed posting lists, ranked by edit
+  distance so names are found even with typos.
+- Dirty shards and checkpoint pages: which shard files and checkpoint pages a change makes stale.
+- Store mutations: addClientToStore / updateClientInStore / markClientAsDeletedInStore update all of the above.
+*/
+
+#include "bank_store.h"
+
+// ------------------------------------------------------ ACCOUNT INDEX ------------------------------------------------------
+// *****************************************************************************************************************
+
+// FNV-1a hash of the account number
+inline size_t hashAccountNumber(string_view accountNumber)
+{
+    size_t hash = 1469598103934665603ULL;
+    for (unsigned char c : accountNumber)
+    {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// Shard file of an account: the FNV-1a hash mixed once more (murmur3 finalizer step), since its bits are
+// uneven on short keys that differ only in their last digits
+inline size_t shardOfAccount(const sShardedStorage &shards, string_view accountNumber)
+{
+    uint64_t hash = hashAccountNumber(accountNumber);
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDULL;
+    hash ^= hash >> 33;
+    return hash % shards.shardCount;
+}
+
+// Returns the index entry position for the account number, or the first free position if it is not indexed
+inline size_t probeAccountIndex(const sClientStore &store, string_view accountNumber, bool &found)
+{
+    const vector<int> &entries = store.accountIndex.entries;
+    size_t mask = entries.size() - 1;
+    size_t pos = hashAccountNumber(accountNumber) & mask;
+    size_t firstFree = entries.size();
+
+    found = false;
+    while (true)
+    {
+        int entry = entries[pos];
+        if (entry == emptyIndexEntry)
+            return (firstFree != entries.size()) ? firstFree : pos;
+
+        if (entry == deletedIndexEntry)
+        {
+            if (firstFree == entries.size())
+                firstFree = pos;
+        }
+        else if (slotAccountNumber(store.clients, entry) == accountNumber)
+        {
+            found = true;
+            return pos;
+        }
+        pos = (pos + 1) & mask;
+    }
+}
+
+inline int insertIntoAccountIndex(sClientStore &store, int slot);
+
+// Rebuilds the index over the first 'slotCount' clients with room for at least 'capacity' clients
+// (power-of-two table, max load factor 0.75)
+inline void rehashAccountIndex(sClientStore &store, size_t capacity, size_t slotCount)
+{
+    size_t size = 16;
+    while (size * 3 < capacity * 4)
+        size *= 2;
+
+    sAccountIndex &index = store.accountIndex;
+    index.entries.assign(size, emptyIndexEntry);
+    index.used = 0;
+    index.live = 0;
+
+    for (size_t slot = 0; slot < slotCount; slot++)
+    {
+        if (!isSlotDeleted(store.clients, slot))
+            insertIntoAccountIndex(store, static_cast<int>(slot));
+    }
+}
+
+// Indexes the client stored at 'slot'. A client already indexed under the same account number
+// is replaced and marked for delete, so the most recent record always wins; its slot is returned (else -1).
+inline int insertIntoAccountIndex(sClientStore &store, int slot)
+{
+    sAccountIndex &index = store.accountIndex;
+    if (index.entries.empty() || (index.used + 1) * 4 > index.entries.size() * 3)
+        rehashAccountIndex(store, (index.live + 1) * 2, slot);
+
+    bool found;
+    size_t pos = probeAccountIndex(store, slotAccountNumber(store.clients, slot), found);
+    if (found)
+    {
+        int replacedSlot = index.entries[pos];
+        store.clients.deleted[replacedSlot] = 1;
+        index.entries[pos] = slot;
+        return replacedSlot;
+    }
+
+    if (index.entries[pos] == emptyIndexEntry)
+        index.used++;
+    index.entries[pos] = slot;
+    index.live++;
+    return -1;
+}
+
+// Rebuilds the whole index from the slots (after loading or compacting the store)
+inline void rebuildAccountIndex(sClientStore &store)
+{
+    rehashAccountIndex(store, slotCount(store.clients), slotCount(store.clients));
+}
+
+// Returns the slot of the client with this account number, or -1 if there is no such (live) client
+inline int findClientSlot(const sClientStore &store, string_view accountNumber)
+{
+    if (store.accountIndex.entries.empty())
+        return -1;
+
+    bool found;
+    size_t pos = probeAccountIndex(store, accountNumber, found);
+    return found ? store.accountIndex.entries[pos] : -1;
+}
+
+// ------------- Columnar copy -------------
+// ------------- ------------- -------------
+
+inline void appendColumnsRow(sClientStore &store, int slot)
+{
+    sClientColumns &columns = store.columns;
+    if (columns.rowOfSlot.size() <= static_cast<size_t>(slot))
+        columns.rowOfSlot.resize(slot + 1, -1);
+    columns.rowOfSlot[slot] = static_cast<int>(columns.slotOfRow.size());
+    columns.slotOfRow.push_back(slot);
+    columns.balances.push_back(store.clients.balances[slot].cents);
+}
+
+inline void updateColumnsRow(sClientStore &store, int slot)
+{
+    sClientColumns &columns = store.columns;
+    columns.balances[columns.rowOfSlot[slot]] = store.clients.balances[slot].cents;
+}
+
+// Removes the slot's row by moving the last row into its place
+inline void removeColumnsRow(sClientStore &store, int slot)
+{
+    sClientColumns &columns = store.columns;
+    int row = columns.rowOfSlot[slot];
+    int lastRow = static_cast<int>(columns.slotOfRow.size() - 1);
+
+    if (row != lastRow)
+    {
+        int movedSlot = columns.slotOfRow[lastRow];
+        columns.slotOfRow[row] = movedSlot;
+        columns.rowOfSlot[movedSlot] = row;
+        columns.balances[row] = columns.balances[lastRow];
+    }
+    columns.rowOfSlot[slot] = -1;
+    columns.slotOfRow.pop_back();
+    columns.balances.pop_back();
+}
+
+// Rebuilds the columns from the live slots
+inline void rebuildClientColumns(sClientStore &store)
+{
+    store.columns = sClientColumns();
+    store.columns.rowOfSlot.assign(slotCount(store.clients), -1);
+    store.columns.balances.reserve(store.accountIndex.live);
+    store.columns.slotOfRow.reserve(store.accountIndex.live);
+    for (size_t slot = 0; slot < slotCount(store.clients); slot++)
+    {
+        if (!isSlotDeleted(store.clients, slot))
+            appendColumnsRow(store, static_cast<int>(slot));
+    }
+}
+// ------------- ------------- -------------
+
+// ------------- Prefix indexes -------------
+// ------------- ------------- -------------
+
+// The indexed field of the client in 'slot' (the phone is unpacked from its digits)
+inline string prefixFieldOf(const sClientSlots &slots, int slot, enPrefixField field)
+{
+    return field == PrefixPhone ? compactPhone(slots.records[slot]) : string(slotAccountNumber(slots, slot));
+}
+
+// Zero-padded key of 'keyWidth' bytes (longer values are cut, queries are cut the same way)
+inline void makePrefixKey(string_view value, size_t keyWidth, char *key)
+{
+    size_t length = min(value.size(), keyWidth);
+    memcpy(key, value.data(), length);
+    memset(key + length, 0, keyWidth - length);
+}
+
+// True if the entry still describes its client (not deleted, field not changed since)
+inline bool isPrefixEntryCurrent(const sClientStore &store, const sPrefixIndex &index, const char *key, int slot)
+{
+    if (static_cast<size_t>(slot) >= store.columns.rowOfSlot.size() || store.columns.rowOfSlot[slot] == -1)
+        return false;
+
+    char current[accountNumberCapacity];
+    makePrefixKey(prefixFieldOf(store.clients, slot, index.field), index.keyWidth, current);
+    return memcmp(current, key, index.keyWidth) == 0;
+}
+
+// Entries are ordered by key, then by slot, so that two copies of one (key, slot) always end up next to each other
+inline int comparePrefixEntries(const char *keyA, int slotA, const char *keyB, int slotB, size_t keyWidth)
+{
+    int order = memcmp(keyA, keyB, keyWidth);
+    if (order != 0)
+        return order;
+    return (slotA < slotB) ? -1 : (slotA > slotB);
+}
+
+// Sorts the entries [keys, slots) by key and slot; returns the order as positions
+inline vector<size_t> sortedPrefixOrder(const vector<char> &keys, const vector<int> &slots, size_t keyWidth)
+{
+    vector<size_t> order(slots.size());
+    for (size_t i = 0; i < order.size(); i++)
+        order[i] = i;
+    sort(order.begin(), order.end(), [&](size_t a, size_t b)
+         { return comparePrefixEntries(&keys[a * keyWidth], slots[a], &keys[b * keyWidth], slots[b], keyWidth) < 0; });
+    return order;
+}
+
+// Merges the recent entries into the sorted array and drops every entry that is no longer current
+inline void mergePrefixIndex(const sClientStore &store, sPrefixIndex &index)
+{
+    size_t width = index.keyWidth;
+    vector<size_t> recentOrder = sortedPrefixOrder(index.recentKeys, index.recentSlots, width);
+
+    vector<char> keys;
+    vector<int> slots;
+    keys.reserve(index.keys.size() + index.recentKeys.size());
+    slots.reserve(index.slots.size() + index.recentSlots.size());
+
+    auto keep = [&](const char *key, int slot)
+    {
+        // the same (key, slot) can be indexed twice when a field is changed and changed back; both inputs are
+        // in (key, slot) order, so the copies meet here one after the other
+        bool duplicate = !slots.empty() && slots.back() == slot && memcmp(&keys[keys.size() - width], key, width) == 0;
+        if (!duplicate && isPrefixEntryCurrent(store, index, key, slot))
+        {
+            keys.insert(keys.end(), key, key + width);
+            slots.push_back(slot);
+        }
+    };
+
+    size_t main = 0, recent = 0;
+    while (main < index.slots.size() || recent < recentOrder.size())
+    {
+        const char *mainKey = main < index.slots.size() ? &index.keys[main * width] : nullptr;
+        const char *recentKey = recent < recentOrder.size() ? &index.recentKeys[recentOrder[recent] * width] : nullptr;
+        if (recentKey == nullptr ||
+            (mainKey != nullptr && comparePrefixEntries(mainKey, index.slots[main], recentKey, index.recentSlots[recentOrder[recent]], width) <= 0))
+        {
+            keep(mainKey, index.slots[main]);
+            main++;
+        }
+        else
+        {
+            keep(recentKey, index.recentSlots[recentOrder[recent]]);
+            recent++;
+        }
+    }
+
+    index.keys.swap(keys);
+    index.slots.swap(slots);
+    index.recentKeys.clear();
+    index.recentSlots.clear();
+    index.staleEntries = 0;
+}
+
+inline void addToPrefixIndex(const sClientStore &store, sPrefixIndex &index, int slot)
+{
+    size_t width = index.keyWidth;
+    index.recentKeys.resize(index.recentKeys.size() + width);
+    makePrefixKey(prefixFieldOf(store.clients, slot, index.field), width, &index.recentKeys[index.recentKeys.size() - width]);
+    index.recentSlots.push_back(slot);
+
+    if (index.recentSlots.size() >= prefixIndexMergeThreshold)
+        mergePrefixIndex(store, index);
+}
+
+// Counts an entry that stopped being current; once half the sorted array is stale it is merged (purged)
+inline void notePrefixEntryStale(const sClientStore &store, sPrefixIndex &index)
+{
+    index.staleEntries++;
+    if (index.staleEntries > index.slots.size() / 2 + prefixIndexMergeThreshold)
+        mergePrefixIndex(store, index);
+}
+
+inline void rebuildPrefixIndex(const sClientStore &store, sPrefixIndex &index, enPrefixField field, size_t keyWidth)
+{
+    index = sPrefixIndex();
+    index.field = field;
+    index.keyWidth = keyWidth;
+
+    for (int slot : store.columns.slotOfRow)
+    {
+        index.recentKeys.resize(index.recentKeys.size() + keyWidth);
+        makePrefixKey(prefixFieldOf(store.clients, slot, field), keyWidth, &index.recentKeys[index.recentKeys.size() - keyWidth]);
+        index.recentSlots.push_back(slot);
+    }
+    mergePrefixIndex(store, index);
+}
+
+inline void rebuildPrefixIndexes(sClientStore &store)
+{
+    rebuildPrefixIndex(store, store.phoneIndex, PrefixPhone, phoneCapacity);
+    rebuildPrefixIndex(store, store.accountPrefixIndex, PrefixAccountNumber, accountNumberCapacity);
+}
+
+// The slots of the first 'limit' clients (in key order) whose field starts with 'prefix'
+inline vector<int> findByPrefix(const sClientStore &store, const sPrefixIndex &index, string_view prefix, size_t limit)
+{
+    size_t width = index.keyWidth;
+    size_t prefixLength = min(prefix.size(), width);
+    struct sMatch
+    {
+        const char *key;
+        int slot;
+    };
+    vector<sMatch> matches;
+
+    // sorted part: binary search to the first key >= prefix, then walk while the prefix matches;
+    // 'limit' current entries are enough, nothing later in the array can come first
+    size_t low = 0, high = index.slots.size();
+    while (low < high)
+    {
+        size_t middle = (low + high) / 2;
+        if (memcmp(&index.keys[middle * width], prefix.data(), prefixLength) < 0)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    for (size_t i = low; i < index.slots.size() && matches.size() < limit; i++)
+    {
+        const char *key = &index.keys[i * width];
+        if (memcmp(key, prefix.data(), prefixLength) != 0)
+            break;
+        if (isPrefixEntryCurrent(store, index, key, index.slots[i]))
+            matches.push_back({key, index.slots[i]});
+    }
+
+    // recent part: short, scanned in full
+    for (size_t i = 0; i < index.recentSlots.size(); i++)
+    {
+        const char *key = &index.recentKeys[i * width];
+        if (memcmp(key, prefix.data(), prefixLength) == 0 && isPrefixEntryCurrent(store, index, key, index.recentSlots[i]))
+            matches.push_back({key, index.recentSlots[i]});
+    }
+
+    sort(matches.begin(), matches.end(), [&](const sMatch &a, const sMatch &b)
+         {
+             int order = memcmp(a.key, b.key, width);
+             return order != 0 ? order < 0 : a.slot < b.slot; });
+
+    vector<int> slots;
+    for (const sMatch &match : matches)
+    {
+        if (slots.size() == limit)
+            break;
+        if (slots.empty() || slots.back() != match.slot)
+            slots.push_back(match.slot);
+    }
+    return slots;
+}
+// ------------- ------------- -------------
+
+// ------------- Name trigram index -------------
+// ------------- ------------- -------------
+
+// Lower-cased name with two leading and one trailing space, so word starts make their own trigrams
+inline string normalizeNameForTrigrams(string_view name)
+{
+    string normalized = "  ";
+    for (unsigned char c : name)
+        normalized += static_cast<char>(tolower(c));
+    normalized += ' ';
+    return normalized;
+}
+
+// The distinct trigrams of a name, each packed into the low 3 bytes of an integer
+inline vector<uint32_t> nameTrigrams(string_view name)
+{
+    string normalized = normalizeNameForTrigrams(name);
+    vector<uint32_t> trigrams;
+    for (size_t i = 0; i + 3 <= normalized.size(); i++)
+    {
+        trigrams.push_back((static_cast<uint32_t>(static_cast<unsigned char>(normalized[i])) << 16) |
+                           (static_cast<uint32_t>(static_cast<unsigned char>(normalized[i + 1])) << 8) |
+                           static_cast<unsigned char>(normalized[i + 2]));
+    }
+    sort(trigrams.begin(), trigrams.end());
+    trigrams.erase(unique(trigrams.begin(), trigrams.end()), trigrams.end());
+    return trigrams;
+}
+
+inline void appendToPostingList(sPostingList &list, int slot)
+{
+    auto removed = lower_bound(list.removed.begin(), list.removed.end(), slot);
+    if (removed != list.removed.end() && *removed == slot)
+    {
+        list.removed.erase(removed); // still encoded in the list, it only has to stop being skipped
+        list.count++;
+        return;
+    }
+    if (slot == list.lastSlot)
+        return;
+    if (slot < list.lastSlot)
+    {
+        list.unsorted.push_back(slot); // a renamed client: its slot is older than the list's end
+        return;
+    }
+
+    // varint of the gap, 7 bits per byte, high bit = more bytes follow
+    uint32_t gap = static_cast<uint32_t>(slot - list.lastSlot);
+    while (gap >= 0x80)
+    {
+        list.bytes.push_back(static_cast<uint8_t>(gap | 0x80));
+        gap >>= 7;
+    }
+    list.bytes.push_back(static_cast<uint8_t>(gap));
+    list.lastSlot = slot;
+    list.count++;
+}
+
+// Calls 'visit' for every slot in the list (sorted part first, then the unsorted extras), skipping removed ones
+template <typename Visit>
+void forEachPostingSlot(const sPostingList &list, Visit visit)
+{
+    int slot = -1;
+    uint32_t gap = 0;
+    int shift = 0;
+    size_t removed = 0; // the sorted part ascends, so the removed slots are passed in step with it
+    for (uint8_t byte : list.bytes)
+    {
+        gap |= static_cast<uint32_t>(byte & 0x7F) << shift;
+        if (byte & 0x80)
+        {
+            shift += 7;
+            continue;
+        }
+        slot += static_cast<int>(gap);
+        gap = 0;
+        shift = 0;
+        while (removed < list.removed.size() && list.removed[removed] < slot)
+            removed++;
+        if (removed == list.removed.size() || list.removed[removed] != slot)
+            visit(slot);
+    }
+    for (int extra : list.unsorted)
+    {
+        if (!binary_search(list.removed.begin(), list.removed.end(), extra))
+            visit(extra);
+    }
+}
+
+// Takes a slot that is in the list out of it; once the removed slots pass 1/8 of the list it is re-encoded without them
+inline void removeFromPostingList(sPostingList &list, int slot)
+{
+    auto removed = lower_bound(list.removed.begin(), list.removed.end(), slot);
+    if (removed != list.removed.end() && *removed == slot)
+        return;
+    list.removed.insert(removed, slot);
+    list.count--;
+    if (list.removed.size() < 16 + list.count / 8)
+        return;
+
+    vector<int> slots;
+    slots.reserve(list.count);
+    forEachPostingSlot(list, [&](int kept)
+                       { slots.push_back(kept); });
+    sort(slots.begin(), slots.end());
+    list = sPostingList();
+    for (int kept : slots)
+        appendToPostingList(list, kept);
+}
+
+inline void addToNameIndex(sClientStore &store, int slot)
+{
+    for (uint32_t trigram : nameTrigrams(slotFullName(store.clients, slot)))
+        appendToPostingList(store.nameIndex.postings[trigram], slot);
+}
+
+// Takes the slot out of the lists of its current name's trigrams (call before the name changes)
+inline void removeFromNameIndex(sClientStore &store, int slot)
+{
+    for (uint32_t trigram : nameTrigrams(slotFullName(store.clients, slot)))
+    {
+        auto list = store.nameIndex.postings.find(trigram);
+        if (list == store.nameIndex.postings.end())
+            continue;
+        removeFromPostingList(list->second, slot);
+        if (list->second.count == 0)
+            store.nameIndex.postings.erase(list);
+    }
+}
+
+inline void rebuildNameIndex(sClientStore &store)
+{
+    store.nameIndex = sNameIndex();
+    for (size_t slot = 0; slot < slotCount(store.clients); slot++)
+    {
+        if (store.columns.rowOfSlot[slot] != -1)
+            addToNameIndex(store, static_cast<int>(slot));
+    }
+}
+
+// Fewest edits that turn 'query' (already lower-cased) into some substring of 'text' (compared lower-cased)
+inline int substringEditDistance(const string &query, string_view text)
+{
+    vector<int> previous(text.size() + 1, 0), current(text.size() + 1);
+    for (size_t i = 1; i <= query.size(); i++)
+    {
+        current[0] = static_cast<int>(i);
+        for (size_t j = 1; j <= text.size(); j++)
+        {
+            char textChar = static_cast<char>(tolower(static_cast<unsigned char>(text[j - 1])));
+            int substitute = previous[j - 1] + (query[i - 1] == textChar ? 0 : 1);
+            current[j] = min({previous[j] + 1, current[j - 1] + 1, substitute});
+        }
+        previous.swap(current);
+    }
+    return *min_element(previous.begin(), previous.end());
+}
+
+// The best 'limit' live clients whose name contains the query with at most 'maxEdits' typos,
+// closest first. Each edit destroys at most 3 trigrams of the query, and a match in the middle of a word
+// loses the query's 3 boundary trigrams (two leading, one trailing) for free, so a client sharing 'n' of its
+// 'T' trigrams is at least (T - n - 3) / 3 edits away: only clients reaching T - 3 - 3 * maxEdits are
+// candidates, and they are compared best-sharing first until no remaining one can be closer than the current
+// top 'limit' (ties with them are not searched for; equal distances are ordered by name length).
+inline vector<sNameMatch> findByName(const sClientStore &store, const string &query, int maxEdits, size_t limit)
+{
+    vector<sNameMatch> matches;
+    string loweredQuery = normalizeNameForTrigrams(query).substr(2);
+    loweredQuery.pop_back();
+    if (loweredQuery.empty() || limit == 0)
+        return matches;
+
+    vector<uint32_t> trigrams = nameTrigrams(query);
+    int trigramCount = static_cast<int>(trigrams.size());
+    int threshold = max(1, trigramCount - 3 - 3 * maxEdits);
+
+    // counters only for the slots the lists name; they are set back to 0 before returning
+    vector<uint16_t> &shared = store.nameIndex.sharedCounts;
+    if (shared.size() < slotCount(store.clients))
+        shared.resize(slotCount(store.clients), 0);
+    vector<int> touched, candidates;
+    for (uint32_t trigram : trigrams)
+    {
+        auto list = store.nameIndex.postings.find(trigram);
+        if (list == store.nameIndex.postings.end())
+            continue;
+        forEachPostingSlot(list->second, [&](int slot)
+                           {
+                               if (shared[slot]++ == 0)
+                                   touched.push_back(slot);
+                               if (shared[slot] == threshold)
+                                   candidates.push_back(slot); });
+    }
+
+    // most shared trigrams first (a stable counting sort keeps slot order within a count)
+    vector<vector<int>> byShared(trigramCount + 1);
+    for (int slot : candidates)
+        byShared[min<int>(shared[slot], trigramCount)].push_back(slot);
+    for (int slot : touched)
+        shared[slot] = 0;
+
+    priority_queue<int> bestDistances; // distances of the best 'limit' matches so far, worst on top
+    for (int count = trigramCount; count >= threshold; count--)
+    {
+        int lowerBound = (max(0, trigramCount - count - 3) + 2) / 3;
+        for (int slot : byShared[count])
+        {
+            if (bestDistances.size() == limit && lowerBound >= bestDistances.top())
+                break;
+
+            if (store.columns.rowOfSlot[slot] == -1)
+                continue; // deleted since it was indexed
+
+            int distance = substringEditDistance(loweredQuery, slotFullName(store.clients, slot));
+            if (distance > maxEdits)
+                continue;
+            matches.push_back({slot, distance});
+            bestDistances.push(distance);
+            if (bestDistances.size() > limit)
+                bestDistances.pop();
+        }
+        if (bestDistances.size() == limit && lowerBound >= bestDistances.top())
+            break;
+    }
+
+    sort(matches.begin(), matches.end(), [&](const sNameMatch &a, const sNameMatch &b)
+         {
+             if (a.distance != b.distance)
+                 return a.distance < b.distance;
+             size_t lengthA = slotFullName(store.clients, a.slot).size(), lengthB = slotFullName(store.clients, b.slot).size();
+             return lengthA != lengthB ? lengthA < lengthB : a.slot < b.slot; });
+    if (matches.size() > limit)
+        matches.resize(limit);
+    return matches;
+}
+// ------------- ------------- -------------
+
+// The indexes used by the search screens (prefix and name)
+inline void rebuildSearchIndexes(sClientStore &store)
+{
+    rebuildPrefixIndexes(store);
+    rebuildNameIndex(store);
+}
+
+// ------------- Dirty shards -------------
+// ------------- ------------- -------------
+
+// Flags the shard file holding 'slot' as out of date (sharded storage only)
+inline void markShardChanged(sClientStore &store, int slot)
+{
+    sShardedStorage &shards = store.shards;
+    if (shards.shardCount != 0)
+        shards.dirtyShards[shardOfAccount(shards, slotAccountNumber(store.clients, slot))].store(true, memory_order_relaxed);
+}
+
+// After loading the shards (or writing every one of them) no shard file differs from the store
+inline void markAllShardsWritten(sClientStore &store)
+{
+    sShardedStorage &shards = store.shards;
+    shards.dirtyShards.reset(new atomic<bool>[shards.shardCount]);
+    for (size_t i = 0; i < shards.shardCount; i++)
+        shards.dirtyShards[i].store(false, memory_order_relaxed);
+}
+// ------------- ------------- -------------
+
+// ------------- Checkpoint pages -------------
+// ------------- ------------- -------------
+
+// Flags the checkpoint page of 'slot' as changed. Only adds grow the page table, and adds never run
+// alongside the concurrent transactions that flag existing slots.
+inline void markSlotChanged(sClientStore &store, int slot)
+{
+    markShardChanged(store, slot);
+
+    sCheckpointState &checkpoint = store.checkpoint;
+    checkpoint.changes.fetch_add(1, memory_order_relaxed);
+    if (checkpoint.allDirty)
+        return;
+
+    size_t page = slot / checkpointPageRecords;
+    if (page >= checkpoint.pageCapacity)
+    {
+        size_t capacity = max(page + 1, checkpoint.pageCapacity * 2);
+        unique_ptr<atomic<bool>[]> pages(new atomic<bool>[capacity]);
+        for (size_t i = 0; i < capacity; i++)
+            pages[i].store(i < checkpoint.pageCapacity && checkpoint.dirtyPages[i].load(memory_order_relaxed), memory_order_relaxed);
+        checkpoint.dirtyPages = move(pages);
+        checkpoint.pageCapacity = capacity;
+    }
+    checkpoint.dirtyPages[page].store(true, memory_order_relaxed);
+}
+
+// After a checkpoint (or after loading one) no page differs from the file
+inline void markAllSlotsCheckpointed(sClientStore &store)
+{
+    sCheckpointState &checkpoint = store.checkpoint;
+    size_t pages = slotCount(store.clients) / checkpointPageRecords + 1;
+    checkpoint.dirtyPages.reset(new atomic<bool>[pages]);
+    for (size_t i = 0; i < pages; i++)
+        checkpoint.dirtyPages[i].store(false, memory_order_relaxed);
+    checkpoint.pageCapacity = pages;
+    checkpoint.allDirty = false;
+    checkpoint.changes = 0;
+}
+// ------------- ------------- -------------
+
+// Rebuilds everything derived from the slots (after loading or compacting the store)
+inline void rebuildClientStoreIndexes(sClientStore &store)
+{
+    rebuildAccountIndex(store);
+    rebuildClientColumns(store);
+    rebuildSearchIndexes(store);
+    store.checkpoint.allDirty = true; // slots may have been renumbered
+    store.tombstones.inMemory = count(store.clients.deleted.begin(), store.clients.deleted.end(), 1);
+}
+
+// Appends a client to the store and indexes it; returns its slot (-1 if it could not be stored)
+inline int addClientToStore(sClientStore &store, const sClient &client)
+{
+    if (!appendClientSlot(store.clients, client))
+        return -1; // a field too long for a compact record (parsed and validated clients never are)
+    int slot = static_cast<int>(slotCount(store.clients) - 1);
+    int replacedSlot = insertIntoAccountIndex(store, slot);
+    if (replacedSlot != -1)
+    {
+        removeFromNameIndex(store, replacedSlot);
+        removeColumnsRow(store, replacedSlot);
+        notePrefixEntryStale(store, store.phoneIndex);
+        notePrefixEntryStale(store, store.accountPrefixIndex);
+    }
+    appendColumnsRow(store, slot);
+    addToPrefixIndex(store, store.phoneIndex, slot);
+    addToPrefixIndex(store, store.accountPrefixIndex, slot);
+    addToNameIndex(store, slot);
+    markSlotChanged(store, slot);
+    return slot;
+}
+
+// Bulk variant of addClientToStore for a new account number: only the account index and the columns
+// are updated, the caller rebuilds the search indexes once at the end (rebuildSearchIndexes)
+inline int addClientToStoreDeferringSearchIndexes(sClientStore &store, const sClient &client)
+{
+    if (!appendClientSlot(store.clients, client))
+        return -1;
+    int slot = static_cast<int>(slotCount(store.clients) - 1);
+    insertIntoAccountIndex(store, slot);
+    appendColumnsRow(store, slot);
+    markSlotChanged(store, slot);
+    return slot;
+}
+
+// Replaces the record of an existing client in place; returns false if the account does not exist
+// (or the new record does not fit in the store)
+inline bool updateClientInStore(sClientStore &store, const sClient &client)
+{
+    int slot = findClientSlot(store, client.accountNumber);
+    if (slot == -1 || !fitsInCompactRecord(client.accountNumber, client.fullName))
+        return false;
+
+    bool phoneChanged = compactPhone(store.clients.records[slot]) != client.phone;
+    bool nameChanged = slotFullName(store.clients, slot) != client.fullName;
+    if (nameChanged)
+        removeFromNameIndex(store, slot); // from the old name's lists, the new name is added below
+    replaceClientAtSlot(store.clients, slot, client);
+    updateColumnsRow(store, slot);
+    if (phoneChanged)
+    {
+        notePrefixEntryStale(store, store.phoneIndex);
+        addToPrefixIndex(store, store.phoneIndex, slot);
+    }
+    if (nameChanged)
+        addToNameIndex(store, slot);
+    markSlotChanged(store, slot);
+    return true;
+}
+
+// Marks the client as deleted and drops it from the index; returns false if the account does not exist
+inline bool markClientAsDeletedInStore(sClientStore &store, const string &accountNumber)
+{
+    if (store.accountIndex.entries.empty())
+        return false;
+
+    bool found;
+    size_t pos = probeAccountIndex(store, accountNumber, found);
+    if (!found)
+        return false;
+
+    int slot = store.accountIndex.entries[pos];
+    removeFromNameIndex(store, slot);
+    store.clients.deleted[slot] = 1;
+    store.accountIndex.entries[pos] = deletedIndexEntry;
+    store.accountIndex.live--;
+    removeColumnsRow(store, slot);
+    notePrefixEntryStale(store, store.phoneIndex);
+    notePrefixEntryStale(store, store.accountPrefixIndex);
+    markSlotChanged(store, slot);
+    store.tombstones.inFiles++;
+    store.tombstones.inMemory++;
+    return true;
+}
+
+// Takes a client that was added to the store but could not be saved back out of it. Its slot stays deleted
+// in memory; the files never held it, so it is no tombstone there.
+inline void discardUnsavedClient(sClientStore &store, const string &accountNumber)
+{
+    if (markClientAsDeletedInStore(store, accountNumber))
+        store.tombstones.inFiles--;
+}
+
+// Drops the clients marked for delete from the slots and re-indexes the remaining ones
+inline void compactClientStore(sClientStore &store)
+{
+    eraseDeletedSlots(store.clients);
+    rebuildClientStoreIndexes(store);
+}
+
+// ensure that the entered account number is not already exists
+inline bool isAccountNumberExist(const string &accountNumber, const sClientStore &store)
+{
+    return findClientSlot(store, accountNumber) != -1;
+}
+
+// *****************************************************************************************************************
+
+#endif
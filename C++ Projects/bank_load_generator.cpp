@@ -0,0 +1,211 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <random>
+#include <algorithm>
+#include <cstring>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+using namespace std;
+/*
+=======================================
+Bank Server Load Generator
+=======================================
+
+Drives `bank_system --server` over its Unix domain socket and reports throughput and latency.
+
+- Sends LIST once to learn the existing clients.
+- Opens C connections, one thread each; every connection sends R requests one after another:
+  FIND for a random client, or (W% of the time) UPDATE of a random client's balance.
+- Prints requests/sec and the p50 / p99 / max latency over all requests.
+
+Usage: bank_load_generator [SOCKET=bank.sock] [CONNECTIONS=4] [REQUESTS=10000] [WRITE_PERCENT=10]
+Build: g++ -std=c++17 -O2 -pthread bank_load_generator.cpp -o bank_load_generator
+*/
+
+const string delim = "#||#";
+
+struct sConnection
+{
+    int fd = -1;
+    string buffer; // bytes received after the last complete line
+};
+
+bool connectToServer(const string &socketPath, sConnection &connection)
+{
+    connection.fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (connection.fd == -1)
+        return false;
+
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+    return connect(connection.fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) == 0;
+}
+
+bool sendLine(sConnection &connection, const string &line)
+{
+    string data = line + "\n";
+    size_t sent = 0;
+    while (sent < data.size())
+    {
+        ssize_t n = send(connection.fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0)
+            return false;
+        sent += n;
+    }
+    return true;
+}
+
+bool readLine(sConnection &connection, string &line)
+{
+    size_t newline;
+    while ((newline = connection.buffer.find('\n')) == string::npos)
+    {
+        char chunk[64 * 1024];
+        ssize_t n = recv(connection.fd, chunk, sizeof(chunk), 0);
+        if (n <= 0)
+            return false;
+        connection.buffer.append(chunk, n);
+    }
+    line = connection.buffer.substr(0, newline);
+    connection.buffer.erase(0, newline + 1);
+    return true;
+}
+
+// LIST answers "OK#||#<count>" followed by <count> client lines
+bool fetchClientLines(const string &socketPath, vector<string> &clientLines)
+{
+    sConnection connection;
+    if (!connectToServer(socketPath, connection) || !sendLine(connection, "LIST"))
+        return false;
+
+    string header;
+    if (!readLine(connection, header) || header.rfind("OK" + delim, 0) != 0)
+        return false;
+
+    size_t count = stoul(header.substr(2 + delim.size()));
+    clientLines.resize(count);
+    for (string &line : clientLines)
+    {
+        if (!readLine(connection, line))
+            return false;
+    }
+    close(connection.fd);
+    return true;
+}
+
+// Replaces the balance (last field) of a client line
+string withBalance(const string &clientLine, double balance)
+{
+    return clientLine.substr(0, clientLine.rfind(delim) + delim.size()) + to_string(balance);
+}
+
+// Runs one connection's requests and records the latency of each in microseconds
+void runConnection(const string &socketPath, const vector<string> &clientLines, int requests, int writePercent,
+                   unsigned seed, vector<double> &latencies, int &errors)
+{
+    sConnection connection;
+    if (!connectToServer(socketPath, connection))
+    {
+        errors = requests;
+        return;
+    }
+
+    mt19937 random(seed);
+    uniform_int_distribution<size_t> pickClient(0, clientLines.size() - 1);
+    uniform_int_distribution<int> pickPercent(0, 99);
+    string reply;
+
+    latencies.reserve(requests);
+    for (int i = 0; i < requests; i++)
+    {
+        const string &clientLine = clientLines[pickClient(random)];
+        string request;
+        if (pickPercent(random) < writePercent)
+            request = "UPDATE" + delim + withBalance(clientLine, pickPercent(random) * 100.0);
+        else
+            request = "FIND" + delim + clientLine.substr(0, clientLine.find(delim));
+
+        auto start = chrono::steady_clock::now();
+        if (!sendLine(connection, request) || !readLine(connection, reply))
+        {
+            errors += requests - i;
+            break;
+        }
+        chrono::duration<double, micro> elapsed = chrono::steady_clock::now() - start;
+        latencies.push_back(elapsed.count());
+
+        if (reply.rfind("OK", 0) != 0)
+            errors++;
+    }
+    close(connection.fd);
+}
+
+double percentile(vector<double> &values, double p)
+{
+    size_t k = min(values.size() - 1, static_cast<size_t>(p * values.size()));
+    nth_element(values.begin(), values.begin() + k, values.end());
+    return values[k];
+}
+
+int main(int argc, char *argv[])
+{
+    string socketPath = argc > 1 ? argv[1] : "bank.sock";
+    int connections = argc > 2 ? max(1, stoi(argv[2])) : 4;
+    int requests = argc > 3 ? max(1, stoi(argv[3])) : 10000;
+    int writePercent = argc > 4 ? clamp(stoi(argv[4]), 0, 100) : 10;
+
+    vector<string> clientLines;
+    if (!fetchClientLines(socketPath, clientLines))
+    {
+        cerr << "Error: Could not LIST clients from '" << socketPath << "'. Is `bank_system --server` running?\n";
+        return 1;
+    }
+    if (clientLines.empty())
+    {
+        cerr << "Error: The server has no clients to request.\n";
+        return 1;
+    }
+
+    vector<vector<double>> latencies(connections);
+    vector<int> errors(connections, 0);
+    vector<thread> threads;
+
+    auto start = chrono::steady_clock::now();
+    for (int c = 0; c < connections; c++)
+        threads.emplace_back(runConnection, cref(socketPath), cref(clientLines), requests, writePercent, 1000u + c,
+                             ref(latencies[c]), ref(errors[c]));
+    for (thread &t : threads)
+        t.join();
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+
+    vector<double> all;
+    int totalErrors = 0;
+    for (int c = 0; c < connections; c++)
+    {
+        all.insert(all.end(), latencies[c].begin(), latencies[c].end());
+        totalErrors += errors[c];
+    }
+    if (all.empty())
+    {
+        cerr << "Error: No request completed.\n";
+        return 1;
+    }
+
+    cout << fixed << setprecision(1);
+    cout << "Clients on server : " << clientLines.size() << "\n";
+    cout << "Connections       : " << connections << " x " << requests << " requests (" << writePercent << "% updates)\n";
+    cout << "Requests/sec      : " << all.size() / elapsed.count() << "\n";
+    cout << "Latency p50 (us)  : " << percentile(all, 0.50) << "\n";
+    cout << "Latency p99 (us)  : " << percentile(all, 0.99) << "\n";
+    cout << "Latency max (us)  : " << *max_element(all.begin(), all.end()) << "\n";
+    cout << "Errors            : " << totalErrors << "\n";
+
+    return totalErrors == 0 ? 0 : 1;
+}
@@ -0,0 +1,275 @@
+#ifndef BANK_PLATFORM_H
+#define BANK_PLATFORM_H
+
+/*
+=======================================
+Bank platform layer — system headers and OS-specific calls
+=======================================
+
+Every bank module includes this header first. The modules build on POSIX: open / pread / pwrite, mmap, fsync,
+rename, stat and Unix domain sockets. The calls only Linux or glibc provide are wrapped here, each behind a
+feature macro with a fallback, so the rest of the code never names them directly:
+- epoll (server mode)            BANK_HAS_EPOLL; without it --server says it is not available on this system.
+- inotify (store watcher)        openDirectoryWatch returns -1 and the watcher stats the files on every check.
+- sync_file_range (paced writes) startWriteback does nothing; the fsync before the rename still makes the file durable.
+- mallinfo2 (memory report)      heapStatsAvailable is false and --memory-report says so.
+- fdatasync                      syncFileData falls back to fsync where it is missing (macOS).
+- accept4 / SOCK_NONBLOCK        acceptNonBlocking and setNonBlocking use fcntl instead.
+- termios (as-you-type search)   BANK_HAS_TERMIOS; without it the prefix search reads a whole line.
+- st_mtim, ru_maxrss             fileModifiedNanoseconds and peakRssKb hide the per-OS field name and unit.
+*/
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <limits>
+#include <fstream>
+#include <optional>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <atomic>
+#include <unordered_map>
+#include <queue>
+#include <deque>
+#include <map>
+#include <condition_variable>
+#include <csignal>
+#include <random>
+#include <cmath>
+#include <cstring>
+#include <string_view>
+#include <charconv>
+#include <cstdint>
+#include <cstddef>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#include "simd_find.h"
+
+#if defined(__linux__)
+#define BANK_HAS_EPOLL 1
+#define BANK_HAS_INOTIFY 1
+#define BANK_HAS_SYNC_FILE_RANGE 1
+#include <sys/epoll.h>
+#include <sys/inotify.h>
+#endif
+
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+#define BANK_HAS_MALLINFO2 1
+#include <malloc.h>
+#endif
+
+#if __has_include(<termios.h>)
+#define BANK_HAS_TERMIOS 1
+#include <termios.h>
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BANK_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+// ------------------------------------------------------ FILES ------------------------------------------------------
+// *****************************************************************************************************************
+
+// Flushes the file's data (and the metadata needed to read it back) to the disk
+inline int syncFileData(int fd)
+{
+#if defined(__APPLE__)
+    return fsync(fd);
+#else
+    return fdatasync(fd);
+#endif
+}
+
+// Starts writing back 'bytes' bytes at 'offset' without waiting for them, so a later fsync has little left to do
+inline void startWriteback(int fd, uint64_t offset, size_t bytes)
+{
+#ifdef BANK_HAS_SYNC_FILE_RANGE
+    sync_file_range(fd, offset, bytes, SYNC_FILE_RANGE_WRITE);
+#else
+    (void)fd;
+    (void)offset;
+    (void)bytes;
+#endif
+}
+
+// Last modification time of a stat'ed file in nanoseconds
+inline int64_t fileModifiedNanoseconds(const struct stat &info)
+{
+#if defined(__APPLE__)
+    return static_cast<int64_t>(info.st_mtimespec.tv_sec) * 1000000000 + info.st_mtimespec.tv_nsec;
+#else
+    return static_cast<int64_t>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+#endif
+}
+
+// Writes the whole buffer to stdout (after whatever cout still holds)
+inline bool writeToStdout(const string &buffer)
+{
+    cout.flush();
+    size_t written = 0;
+    while (written < buffer.size())
+    {
+        ssize_t n = write(STDOUT_FILENO, buffer.data() + written, buffer.size() - written);
+        if (n == -1 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        written += n;
+    }
+    return true;
+}
+
+// *****************************************************************************************************************
+
+// ------------------------------------------------------ DIRECTORY WATCH ------------------------------------------------------
+// *****************************************************************************************************************
+// A non-blocking descriptor that reports changes to the files of one directory (inotify). Where there is none
+// openDirectoryWatch returns -1 and the caller falls back to stat'ing the files it cares about.
+
+// Opens a watch on 'directory'; -1 if the system has none or it could not be set up
+inline int openDirectoryWatch(const string &directory)
+{
+#ifdef BANK_HAS_INOTIFY
+    const uint32_t events = IN_MODIFY | IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO;
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd != -1 && inotify_add_watch(fd, directory.c_str(), events) == -1)
+    {
+        close(fd);
+        fd = -1;
+    }
+    return fd;
+#else
+    (void)directory;
+    return -1;
+#endif
+}
+
+// Reads the pending events of a watch and calls onFile with the name of each changed file; an empty name
+// means events were lost, so anything may have changed
+inline void readDirectoryWatch(int fd, const function<void(const string &name)> &onFile)
+{
+#ifdef BANK_HAS_INOTIFY
+    alignas(inotify_event) char buffer[16 * 1024];
+    ssize_t n;
+    while ((n = read(fd, buffer, sizeof(buffer))) > 0)
+    {
+        for (char *p = buffer; p < buffer + n;)
+        {
+            const inotify_event *event = reinterpret_cast<const inotify_event *>(p);
+            if (event->mask & IN_Q_OVERFLOW)
+                onFile("");
+            else if (event->len > 0)
+                onFile(event->name);
+            p += sizeof(inotify_event) + event->len;
+        }
+    }
+#else
+    (void)fd;
+    (void)onFile;
+#endif
+}
+
+// *****************************************************************************************************************
+
+// ------------------------------------------------------ SOCKETS ------------------------------------------------------
+// *****************************************************************************************************************
+
+inline bool setNonBlocking(int fd)
+{
+    int flags = fcntl(fd, F_GETFL);
+    return flags != -1 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) != -1;
+}
+
+// Accepts one pending connection as a non-blocking socket; -1 when none is waiting
+inline int acceptNonBlocking(int listenFd)
+{
+#if defined(__linux__)
+    return accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK);
+#else
+    int fd = accept(listenFd, nullptr, nullptr);
+    if (fd != -1 && !setNonBlocking(fd))
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+#endif
+}
+
+// *****************************************************************************************************************
+
+// ------------------------------------------------------ TERMINAL ------------------------------------------------------
+// *****************************************************************************************************************
+
+#ifdef BANK_HAS_TERMIOS
+// Switches stdin to one key press at a time without echo; endRawKeyInput restores 'saved'
+inline bool beginRawKeyInput(termios &saved)
+{
+    if (tcgetattr(STDIN_FILENO, &saved) == -1)
+        return false;
+    termios raw = saved;
+    raw.c_lflag &= ~(ICANON | ECHO);
+    raw.c_cc[VMIN] = 1;
+    raw.c_cc[VTIME] = 0;
+    return tcsetattr(STDIN_FILENO, TCSANOW, &raw) == 0;
+}
+
+inline void endRawKeyInput(const termios &saved)
+{
+    tcsetattr(STDIN_FILENO, TCSANOW, &saved);
+}
+#endif
+
+// *****************************************************************************************************************
+
+// ------------------------------------------------------ PROCESS MEMORY ------------------------------------------------------
+// *****************************************************************************************************************
+
+#ifdef BANK_HAS_MALLINFO2
+const bool heapStatsAvailable = true;
+#else
+const bool heapStatsAvailable = false;
+#endif
+
+// Heap bytes in use (small chunks plus mmap'd large blocks), allocator overhead included; 0 where unknown
+inline size_t heapBytesInUse()
+{
+#ifdef BANK_HAS_MALLINFO2
+    struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+#else
+    return 0;
+#endif
+}
+
+// High-water mark of the process's resident memory in KB
+inline long peakRssKb()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+    return usage.ru_maxrss / 1024; // bytes on macOS
+#else
+    return usage.ru_maxrss;
+#endif
+}
+
+// *****************************************************************************************************************
+
+#endif
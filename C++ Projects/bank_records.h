@@ -0,0 +1,682 @@
+#ifndef BANK_RECORDS_H
+#define BANK_RECORDS_H
+
+/*
+=======================================
+Bank client records — money, clients and their text form
+=======================================
+
+- sMoney: balances and amounts as whole cents in a 64-bit integer, read from and written as "units.cc".
+- sClient: one client with its five fields as strings, the form screens and commands work with.
+- Compact records: the store keeps each client in a 24-byte slot (PIN and phone packed as digits) plus its
+  account number and name in a bump-pointer arena; sClientSlots holds the slots, balances and delete flags,
+  and a client is expanded into an sClient only when it is read.
+- Client lines: the delimited text form of a client in Clients.txt, the log and the command protocol.
+- Validation rules: one ...Error() function per field, shared by the prompts, the commands and the import.
+*/
+
+#include "bank_platform.h"
+
+// Field capacities of the fixed-width binary record
+const short accountNumberCapacity = 20;
+const short pinCodeCapacity = 4;
+const short phoneCapacity = 11;
+const short fullNameCapacity = 64;
+
+/*
+ * This function splits the input string `s` into substrings separated by the specified `delimiter`.
+ * Each non-empty substring is added to the vector `vWords`.
+ * The string is walked with offsets (simdFind) instead of being erased from the front after every word.
+ */
+inline void splitString(const string &s, vector<string> &vWords, const string &delimiter)
+{
+
+    size_t start = 0; // Start of the current word
+    size_t pos = 0;   // Position of the delimiter in the string
+
+    if (delimiter.empty())
+    {
+        if (!s.empty())
+            vWords.push_back(s);
+        return;
+    }
+
+    // Loop as long as the delimiter is found in the rest of the string
+    while ((pos = simdFind(s, delimiter, start)) != string::npos)
+    {
+        // Add the substring between the previous delimiter and this one only if it is not empty
+        if (pos > start)
+            vWords.push_back(s.substr(start, pos - start));
+
+        // Continue right after the delimiter
+        start = pos + delimiter.length();
+    }
+
+    // After the loop ends, add any remaining part of the string as the last word if not empty
+    if (start < s.length())
+        vWords.push_back(s.substr(start));
+}
+
+// ------------------------------------------------------ MONEY ------------------------------------------------------
+// ********************************************************************************************************************************
+// Balances and amounts are whole cents in a 64-bit integer, so adding and subtracting them is exact and
+// millions of transactions never drift. As text they are "[-]units.cc"; the parser also takes more decimals
+// (older Clients.txt files were written with six) and rounds them to the nearest cent, half away from zero.
+
+struct sMoney
+{
+    long long cents = 0;
+};
+
+inline sMoney operator+(sMoney a, sMoney b)
+{
+    return sMoney{a.cents + b.cents};
+}
+
+inline sMoney operator-(sMoney a, sMoney b)
+{
+    return sMoney{a.cents - b.cents};
+}
+
+inline sMoney &operator+=(sMoney &a, sMoney b)
+{
+    a.cents += b.cents;
+    return a;
+}
+
+inline sMoney &operator-=(sMoney &a, sMoney b)
+{
+    a.cents -= b.cents;
+    return a;
+}
+
+inline bool operator==(sMoney a, sMoney b)
+{
+    return a.cents == b.cents;
+}
+
+inline bool operator!=(sMoney a, sMoney b)
+{
+    return a.cents != b.cents;
+}
+
+inline bool operator<(sMoney a, sMoney b)
+{
+    return a.cents < b.cents;
+}
+
+inline bool operator>(sMoney a, sMoney b)
+{
+    return a.cents > b.cents;
+}
+
+const int maxMoneyUnitDigits = 16;   // 10^16 units in cents leaves room for sums in a long long
+const long long maxBalanceCents = 999999999999999999; // the largest balance parseMoney reads back (16 digits + cents)
+const size_t moneyTextCapacity = 24; // sign + 19 digits + ".cc", rounded up
+
+inline bool isMoneyDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+// Parses "[+-]digits[.digits]" (no spaces, no exponent) into 'money'; false if it is not one or is too large
+inline bool parseMoney(string_view text, sMoney &money)
+{
+    size_t i = 0;
+    bool negative = false;
+    if (i < text.size() && (text[i] == '-' || text[i] == '+'))
+        negative = (text[i++] == '-');
+
+    bool digitFound = false;
+    long long units = 0;
+    int unitDigits = 0;
+    for (; i < text.size() && isMoneyDigit(text[i]); i++)
+    {
+        digitFound = true;
+        if (units == 0 && text[i] == '0')
+            continue; // leading zeros do not count towards the limit
+        if (++unitDigits > maxMoneyUnitDigits)
+            return false;
+        units = units * 10 + (text[i] - '0');
+    }
+
+    long long cents = 0;
+    if (i < text.size() && text[i] == '.')
+    {
+        int decimals = 0;
+        bool roundUp = false;
+        for (i++; i < text.size() && isMoneyDigit(text[i]); i++, decimals++)
+        {
+            digitFound = true;
+            if (decimals < 2)
+                cents = cents * 10 + (text[i] - '0');
+            else if (decimals == 2)
+                roundUp = (text[i] >= '5'); // only the third decimal decides, the rest is beyond half a cent
+        }
+        if (decimals == 1)
+            cents *= 10;
+        cents += roundUp;
+    }
+
+    if (!digitFound || i != text.size())
+        return false;
+
+    money.cents = negative ? -(units * 100 + cents) : units * 100 + cents;
+    return true;
+}
+
+// Writes "[-]units.cc" into 'buffer' (moneyTextCapacity bytes) without allocating; returns the end of the text
+inline char *formatMoneyTo(char *buffer, sMoney money)
+{
+    unsigned long long magnitude = (money.cents < 0) ? 0ULL - static_cast<unsigned long long>(money.cents) : money.cents;
+    char *out = buffer;
+    if (money.cents < 0)
+        *out++ = '-';
+
+    out = to_chars(out, buffer + moneyTextCapacity, magnitude / 100).ptr;
+    unsigned cents = magnitude % 100;
+    out[0] = '.';
+    out[1] = static_cast<char>('0' + cents / 10);
+    out[2] = static_cast<char>('0' + cents % 10);
+    return out + 3;
+}
+
+inline string formatMoney(sMoney money)
+{
+    char buffer[moneyTextCapacity];
+    return string(buffer, formatMoneyTo(buffer, money));
+}
+
+// Streams honour setw / left like for any other string
+inline ostream &operator<<(ostream &out, sMoney money)
+{
+    char buffer[moneyTextCapacity];
+    return out << string_view(buffer, formatMoneyTo(buffer, money) - buffer);
+}
+
+// Version 1 of Clients.bin stored balances as a double, which cannot hold every balance parseMoney accepts
+// (above 2^53 cents it rounds); it is only read, to convert such a file to whole cents
+inline sMoney moneyFromDouble(double value)
+{
+    return sMoney{llround(value * 100)};
+}
+
+// ********************************************************************************************************************************
+
+// Represents a bank client with basic account and contact information
+struct sClient
+{
+    string accountNumber;
+    string pinCode;
+    string fullName;
+    string phone;
+    sMoney accountBalance;
+    bool markedForDelete = false;
+};
+
+inline bool operator==(const sClient &a, const sClient &b)
+{
+    return a.accountNumber == b.accountNumber;
+}
+
+// ------------------------------------------------------ COMPACT CLIENT RECORDS ------------------------------------------------------
+// ********************************************************************************************************************************
+// An sClient costs four std::strings (32 bytes each, plus a heap block for every value longer than 15 chars).
+// The compact form is 24 bytes: the PIN and phone are packed as 4-bit digits, and the account number and
+// full name are copied into a bump-pointer arena that hands out bytes from 64 KB blocks, so millions of
+// clients cost a few hundred allocations instead of millions. Values that are not all digits (or too long)
+// are kept as text in the arena after the name, so any record that loads can be stored.
+
+const size_t arenaBlockSize = 64 * 1024;
+
+struct sClientArena
+{
+    vector<unique_ptr<char[]>> blocks; // pointers into a block stay valid until the arena is dropped
+    char *current = nullptr;           // block small allocations are bumped from
+    size_t currentUsed = arenaBlockSize;
+    size_t bytes = 0;    // bytes handed out
+    size_t garbage = 0;  // handed-out bytes no longer referenced by any record
+    size_t reserved = 0; // bytes of all blocks
+};
+
+// Returns 'size' bytes that live as long as the arena; large requests get a block of their own
+inline char *allocateInArena(sClientArena &arena, size_t size)
+{
+    arena.bytes += size;
+    if (size > arenaBlockSize / 4)
+    {
+        arena.blocks.push_back(unique_ptr<char[]>(new char[size]));
+        arena.reserved += size;
+        return arena.blocks.back().get();
+    }
+    if (arena.currentUsed + size > arenaBlockSize)
+    {
+        arena.blocks.push_back(unique_ptr<char[]>(new char[arenaBlockSize]));
+        arena.reserved += arenaBlockSize;
+        arena.current = arena.blocks.back().get();
+        arena.currentUsed = 0;
+    }
+    char *data = arena.current + arena.currentUsed;
+    arena.currentUsed += size;
+    return data;
+}
+
+// Packed digits: one 4-bit digit per nibble from the low end, the digit count in the top nibble.
+// A top nibble of digitsInText means the value is text in the arena and the low bits hold its length.
+const unsigned digitsInText = 0xF;
+
+// Packs 'value' into 'bits' bits (top nibble = count); false if it is not all digits or does not fit
+inline bool packDigits(string_view value, int bits, uint64_t &packed)
+{
+    size_t maxDigits = min<size_t>(bits / 4 - 1, digitsInText - 1);
+    if (value.size() > maxDigits)
+        return false;
+
+    packed = static_cast<uint64_t>(value.size()) << (bits - 4);
+    for (size_t i = 0; i < value.size(); i++)
+    {
+        if (!isMoneyDigit(value[i]))
+            return false;
+        packed |= static_cast<uint64_t>(value[i] - '0') << (4 * i);
+    }
+    return true;
+}
+
+inline string unpackDigits(uint64_t packed, int bits)
+{
+    size_t count = packed >> (bits - 4);
+    string value(count, '0');
+    for (size_t i = 0; i < count; i++)
+        value[i] = static_cast<char>('0' + ((packed >> (4 * i)) & 0xF));
+    return value;
+}
+
+inline bool isPackedAsText(uint64_t packed, int bits)
+{
+    return (packed >> (bits - 4)) == digitsInText;
+}
+
+struct sCompactClient
+{
+    const char *text;             // account number, full name, then the PIN / phone if they are not packed
+    uint64_t phone;               // packed digits
+    uint32_t pinCode;             // packed digits
+    uint16_t accountNumberLength; // bytes of 'text'
+    uint16_t fullNameLength;
+};
+
+static_assert(sizeof(sCompactClient) == 24, "compact record layout changed");
+
+inline string_view compactAccountNumber(const sCompactClient &record)
+{
+    return string_view(record.text, record.accountNumberLength);
+}
+
+inline string_view compactFullName(const sCompactClient &record)
+{
+    return string_view(record.text + record.accountNumberLength, record.fullNameLength);
+}
+
+inline size_t compactPinTextLength(const sCompactClient &record)
+{
+    return isPackedAsText(record.pinCode, 32) ? record.pinCode & 0xFFFFFFF : 0;
+}
+
+inline size_t compactPhoneTextLength(const sCompactClient &record)
+{
+    return isPackedAsText(record.phone, 64) ? record.phone & 0xFFFFFFFFFFFFFFFULL : 0;
+}
+
+inline string compactPinCode(const sCompactClient &record)
+{
+    if (!isPackedAsText(record.pinCode, 32))
+        return unpackDigits(record.pinCode, 32);
+    return string(record.text + record.accountNumberLength + record.fullNameLength, compactPinTextLength(record));
+}
+
+inline string compactPhone(const sCompactClient &record)
+{
+    if (!isPackedAsText(record.phone, 64))
+        return unpackDigits(record.phone, 64);
+    size_t offset = record.accountNumberLength + record.fullNameLength + compactPinTextLength(record);
+    return string(record.text + offset, compactPhoneTextLength(record));
+}
+
+// Arena bytes the record refers to
+inline size_t compactTextSize(const sCompactClient &record)
+{
+    return record.accountNumberLength + record.fullNameLength + compactPinTextLength(record) + compactPhoneTextLength(record);
+}
+
+// The account number and name lengths are 16-bit
+inline bool fitsInCompactRecord(string_view accountNumber, string_view fullName)
+{
+    return accountNumber.size() <= numeric_limits<uint16_t>::max() && fullName.size() <= numeric_limits<uint16_t>::max();
+}
+
+// Copies the client into the arena; false if the account number or name is longer than 65535 bytes
+inline bool makeCompactClient(string_view accountNumber, string_view fullName, string_view pinCode, string_view phone,
+                       sClientArena &arena, sCompactClient &record)
+{
+    if (!fitsInCompactRecord(accountNumber, fullName))
+        return false;
+
+    uint64_t packedPin = 0;
+    bool pinPacked = packDigits(pinCode, 32, packedPin);
+    bool phonePacked = packDigits(phone, 64, record.phone);
+    record.pinCode = pinPacked ? static_cast<uint32_t>(packedPin) : (digitsInText << 28) | static_cast<uint32_t>(pinCode.size() & 0xFFFFFFF);
+    if (!phonePacked)
+        record.phone = (static_cast<uint64_t>(digitsInText) << 60) | phone.size();
+    record.accountNumberLength = static_cast<uint16_t>(accountNumber.size());
+    record.fullNameLength = static_cast<uint16_t>(fullName.size());
+
+    char *text = allocateInArena(arena, compactTextSize(record));
+    record.text = text;
+    text = copy(accountNumber.begin(), accountNumber.end(), text);
+    text = copy(fullName.begin(), fullName.end(), text);
+    if (!pinPacked)
+        text = copy(pinCode.begin(), pinCode.end(), text);
+    if (!phonePacked)
+        copy(phone.begin(), phone.end(), text);
+    return true;
+}
+
+inline sClient expandCompactClient(const sCompactClient &record, sMoney balance)
+{
+    sClient client;
+    client.accountNumber = string(compactAccountNumber(record));
+    client.pinCode = compactPinCode(record);
+    client.fullName = string(compactFullName(record));
+    client.phone = compactPhone(record);
+    client.accountBalance = balance;
+    return client;
+}
+
+// ------------- Client slots -------------
+// ------------- ------------- -------------
+// The store's clients, one compact record per slot. A slot keeps its number until the deleted slots are
+// purged: a deleted client stays in its slot, flagged. Screens and commands read a client through
+// clientAtSlot (an sClient expanded on the fly) or through the field accessors, which do not allocate.
+
+struct sClientSlots
+{
+    vector<sCompactClient> records; // slot -> account number, PIN, name, phone
+    vector<sMoney> balances;        // slot -> balance (concurrent transactions change it, see CONCURRENT ACCOUNTS)
+    vector<uint8_t> deleted;        // slot -> 1 once marked for delete (bytes, not bits, so slots never share a write)
+    sClientArena arena;             // text of the records
+};
+
+inline size_t slotCount(const sClientSlots &slots)
+{
+    return slots.records.size();
+}
+
+inline string_view slotAccountNumber(const sClientSlots &slots, size_t slot)
+{
+    return compactAccountNumber(slots.records[slot]);
+}
+
+inline string_view slotFullName(const sClientSlots &slots, size_t slot)
+{
+    return compactFullName(slots.records[slot]);
+}
+
+inline bool isSlotDeleted(const sClientSlots &slots, size_t slot)
+{
+    return slots.deleted[slot] != 0;
+}
+
+inline sClient clientAtSlot(const sClientSlots &slots, size_t slot)
+{
+    sClient client = expandCompactClient(slots.records[slot], slots.balances[slot]);
+    client.markedForDelete = isSlotDeleted(slots, slot);
+    return client;
+}
+
+// Copies the live records into a fresh arena (once half of the arena is garbage)
+inline void repackClientArena(sClientSlots &slots)
+{
+    sClientArena arena;
+    for (sCompactClient &record : slots.records)
+    {
+        char *text = allocateInArena(arena, compactTextSize(record));
+        memcpy(text, record.text, compactTextSize(record));
+        record.text = text;
+    }
+    slots.arena = move(arena);
+}
+
+// Appends a live client; false if a field is too long for a compact record (nothing is appended then)
+inline bool appendClientSlot(sClientSlots &slots, string_view accountNumber, string_view pinCode, string_view fullName, string_view phone,
+                      sMoney balance)
+{
+    sCompactClient record;
+    if (!makeCompactClient(accountNumber, fullName, pinCode, phone, slots.arena, record))
+        return false;
+    slots.records.push_back(record);
+    slots.balances.push_back(balance);
+    slots.deleted.push_back(0);
+    return true;
+}
+
+inline bool appendClientSlot(sClientSlots &slots, const sClient &client)
+{
+    if (!appendClientSlot(slots, client.accountNumber, client.pinCode, client.fullName, client.phone, client.accountBalance))
+        return false;
+    slots.deleted.back() = client.markedForDelete;
+    return true;
+}
+
+// Replaces the client in 'slot' (its old text becomes arena garbage); false if a field is too long
+inline bool replaceClientAtSlot(sClientSlots &slots, size_t slot, const sClient &client)
+{
+    sCompactClient record;
+    if (!makeCompactClient(client.accountNumber, client.fullName, client.pinCode, client.phone, slots.arena, record))
+        return false;
+    slots.arena.garbage += compactTextSize(slots.records[slot]);
+    slots.records[slot] = record;
+    slots.balances[slot] = client.accountBalance;
+    slots.deleted[slot] = client.markedForDelete;
+    if (slots.arena.garbage > slots.arena.bytes / 2)
+        repackClientArena(slots);
+    return true;
+}
+
+// Moves the slots of 'from' behind those of 'to'; the arena blocks move along, so no text is copied
+inline void appendClientSlots(sClientSlots &to, sClientSlots &from)
+{
+    to.records.insert(to.records.end(), from.records.begin(), from.records.end());
+    to.balances.insert(to.balances.end(), from.balances.begin(), from.balances.end());
+    to.deleted.insert(to.deleted.end(), from.deleted.begin(), from.deleted.end());
+    for (unique_ptr<char[]> &block : from.arena.blocks)
+        to.arena.blocks.push_back(move(block));
+    to.arena.bytes += from.arena.bytes;
+    to.arena.garbage += from.arena.garbage;
+    to.arena.reserved += from.arena.reserved;
+    from = sClientSlots();
+}
+
+// Drops the deleted slots (renumbering the others) and repacks the arena without their text
+inline void eraseDeletedSlots(sClientSlots &slots)
+{
+    size_t kept = 0;
+    for (size_t slot = 0; slot < slotCount(slots); slot++)
+    {
+        if (isSlotDeleted(slots, slot))
+            continue;
+        slots.records[kept] = slots.records[slot];
+        slots.balances[kept] = slots.balances[slot];
+        slots.deleted[kept] = 0;
+        kept++;
+    }
+    slots.records.resize(kept);
+    slots.balances.resize(kept);
+    slots.deleted.resize(kept);
+    repackClientArena(slots);
+}
+
+inline void reserveClientSlots(sClientSlots &slots, size_t count)
+{
+    slots.records.reserve(count);
+    slots.balances.reserve(count);
+    slots.deleted.reserve(count);
+}
+
+inline void shrinkClientSlots(sClientSlots &slots)
+{
+    slots.records.shrink_to_fit();
+    slots.balances.shrink_to_fit();
+    slots.deleted.shrink_to_fit();
+}
+// ------------- ------------- -------------
+
+// ********************************************************************************************************************************
+
+// ------------------------------------------------------ CLIENT LINES ------------------------------------------------------
+// *****************************************************************************************************************
+// A client is stored as one line: account number, PIN, name, phone and balance joined by the delimiter.
+
+// Converts a client struct into a delimited string representation for output or storage
+inline string formatClientAsLine(const sClient &client, const string &delim)
+{
+    char balance[moneyTextCapacity];
+    char *balanceEnd = formatMoneyTo(balance, client.accountBalance);
+
+    string line;
+    line.reserve(client.accountNumber.size() + client.pinCode.size() + client.fullName.size() + client.phone.size() +
+                 4 * delim.size() + (balanceEnd - balance));
+    line.append(client.accountNumber).append(delim);
+    line.append(client.pinCode).append(delim);
+    line.append(client.fullName).append(delim);
+    line.append(client.phone).append(delim);
+    line.append(balance, balanceEnd);
+    return line;
+}
+
+// formatClientAsLine for the client in 'slot', appended to 'line' without expanding it into an sClient first
+inline void appendSlotAsLine(string &line, const sClientSlots &slots, size_t slot, const string &delim)
+{
+    char balance[moneyTextCapacity];
+    char *balanceEnd = formatMoneyTo(balance, slots.balances[slot]);
+
+    line.append(slotAccountNumber(slots, slot)).append(delim);
+    line.append(compactPinCode(slots.records[slot])).append(delim);
+    line.append(slotFullName(slots, slot)).append(delim);
+    line.append(compactPhone(slots.records[slot])).append(delim);
+    line.append(balance, balanceEnd);
+}
+
+inline string formatSlotAsLine(const sClientSlots &slots, size_t slot, const string &delim)
+{
+    string line;
+    appendSlotAsLine(line, slots, slot, delim);
+    return line;
+}
+
+// Converts a vector of strings (representing client fields) into a structured sClient;
+// returns false if there are not exactly 5 fields or the balance is not a valid amount
+inline bool parseClientRecord(const vector<string> &vClient, sClient &client)
+{
+    if (vClient.size() != 5)
+        return false;
+
+    client.accountNumber = vClient[0];
+    client.pinCode = vClient[1];
+    client.fullName = vClient[2];
+    client.phone = vClient[3];
+    return parseMoney(vClient[4], client.accountBalance); // Convert "units.cc" to cents
+}
+
+// *****************************************************************************************************************
+
+// ------------------------------------------------------ VALIDATION RULES ------------------------------------------------------
+// *****************************************************************************************************************
+// so the same rules serve the interactive prompts and the non-interactive commands.
+
+inline bool isAllStringDigit(const string &str)
+{
+    return (!str.empty() && all_of(str.begin(), str.end(), [](const char &c)
+                                   { return isdigit(c); }));
+}
+
+inline bool isValidDouble(const string &s)
+{
+    bool decimalFound = false;
+    bool digitFound = false;
+
+    if (s.empty())
+        return false;
+
+    for (char c : s)
+    {
+        if (c == '.')
+        {
+            if (decimalFound)
+                return false; // second decimal point
+            decimalFound = true;
+        }
+        else if (!isdigit(c))
+            return false; // not a digit or '.'
+        else
+            digitFound = true;
+    }
+    return digitFound; // "." alone is not a number
+}
+
+inline string accountNumberFormatError(const string &accountNum)
+{
+    if (accountNum.empty())
+        return "Account number cannot be empty.";
+    if (accountNum.length() > static_cast<size_t>(accountNumberCapacity))
+        return "Account number must be at most " + to_string(accountNumberCapacity) + " characters.";
+    return "";
+}
+
+inline string fullNameError(const string &fullName)
+{
+    if (fullName.length() > static_cast<size_t>(fullNameCapacity))
+        return "Full Name must be at most " + to_string(fullNameCapacity) + " characters.";
+    return "";
+}
+
+inline string phoneNumberError(const string &phoneNum)
+{
+    if (phoneNum.empty())
+        return "Phone Number cannot be empty.";
+    if (!isAllStringDigit(phoneNum))
+        return "Phone Number should contain only digits.";
+    if (!(phoneNum[0] == '0' && phoneNum[1] == '1'))
+        return "Phone number should start with : 01";
+    if (phoneNum.length() != 11)
+        return "Phone number must be 11 digits.";
+    return "";
+}
+
+inline string pinCodeError(const string &pinCode)
+{
+    if (pinCode.empty())
+        return "Pin Number cannot be empty.";
+    if (!isAllStringDigit(pinCode))
+        return "Pin Number should contain only digits.";
+    if (pinCode.length() != 4)
+        return "Pin Number must be only 4 digits.";
+    return "";
+}
+
+inline string accountBalanceError(const string &accountBalance)
+{
+    if (accountBalance.empty())
+        return "Balance cannot be empty.";
+    if (!isValidDouble(accountBalance))
+        return "Balance must be a valid number (digits and at most one decimal point).";
+    sMoney balance;
+    if (!parseMoney(accountBalance, balance))
+        return "Balance is too large.";
+
+    // isValidDouble never lets a '-' through, so the balance cannot be negative here
+    return "";
+}
+
+// *****************************************************************************************************************
+
+#endif
@@ -0,0 +1,527 @@
+#ifndef BANK_SERVER_H
+#define BANK_SERVER_H
+
+/*
+=======================================
+Bank command server — the store over a socket, or a script of commands
+=======================================
+
+- Client commands: FIND / ADD / UPDATE / DELETE / LIST and the money commands, one delimited line each,
+  executed against a loaded store without prompts.
+- Server mode (--server): the store stays resident and serves the commands over a Unix domain socket, one
+  epoll event loop per worker thread, finds sharing a reader-writer lock. Needs epoll (Linux).
+  bank_load_generator.cpp measures requests/sec and latency percentiles against it.
+- Batch mode (--batch): the same command lines read from a file or stdin, each response printed, with a
+  commands/sec summary at the end.
+*/
+
+#include "bank_transactions.h"
+
+// ------------------------------------------------------ CLIENT COMMANDS ------------------------------------------------------
+// *****************************************************************************************************************
+// One command per line, fields separated by the file delimiter:
+//   FIND#||#<account>           -> OK#||#<client line>
+//   ADD#||#<client line>        -> OK
+//   UPDATE#||#<client line>     -> OK
+//   DELETE#||#<account>         -> OK
+//   LIST                        -> OK#||#<count> followed by <count> client lines
+//   STATS                       -> OK#||#tombstones=<n>#||#... (see formatCompactionStats)
+//   DEPOSIT#||#<account>#||#<amount>, WITHDRAW#||#<account>#||#<amount>,
+//   TRANSFER#||#<from>#||#<to>#||#<amount>  -> OK#||#<new balance of the first account>
+// Any failure answers ERR#||#<reason>. The store lock is shared for FIND and for the money commands (which
+// lock only their accounts' stripes; FIND reads its balance under the stripe too), and exclusive for LIST,
+// which reads every balance, and for commands that add, change or remove clients.
+
+const string commandFind = "FIND";
+const string commandAdd = "ADD";
+const string commandUpdate = "UPDATE";
+const string commandDelete = "DELETE";
+const string commandList = "LIST";
+const string commandStats = "STATS";
+const string commandDeposit = "DEPOSIT";
+const string commandWithdraw = "WITHDRAW";
+const string commandTransfer = "TRANSFER";
+
+inline string commandError(const string &reason, const string &delim)
+{
+    return "ERR" + delim + reason + "\n";
+}
+
+// Reads the account(s) and amount of a money command: "<account>#||#<amount>" or "<from>#||#<to>#||#<amount>"
+inline bool parseTransactionCommand(string_view argument, string_view delim, sTransaction &transaction, string &error)
+{
+    vector<string> fields;
+    for (size_t start = 0;;)
+    {
+        size_t pos = simdFind(argument, delim, start);
+        fields.push_back(string(argument.substr(start, pos - start)));
+        if (pos == string_view::npos)
+            break;
+        start = pos + delim.length();
+    }
+
+    size_t expected = (transaction.type == Transfer) ? 3 : 2;
+    if (fields.size() != expected || !isValidDouble(fields.back()) || !parseMoney(fields.back(), transaction.amount))
+    {
+        error = (transaction.type == Transfer) ? "Expected from#to#amount." : "Expected account#amount.";
+        return false;
+    }
+
+    transaction.accountNumber = fields[0];
+    if (transaction.type == Transfer)
+        transaction.toAccountNumber = fields[1];
+    return true;
+}
+
+// Executes one command line against the store and returns the complete response
+inline string executeClientCommand(string_view line, string fileName, string delim, sConcurrentAccounts &accounts, shared_mutex &storeLock)
+{
+    sClientStore &store = *accounts.store;
+
+    if (!line.empty() && line.back() == '\r')
+        line.remove_suffix(1);
+
+    size_t pos = simdFind(line, delim);
+    string command(line.substr(0, pos));
+    string_view argument = (pos == string_view::npos) ? string_view() : line.substr(pos + delim.length());
+
+    if (command == commandFind)
+    {
+        shared_lock<shared_mutex> readLock(storeLock);
+        int slot = findClientSlot(store, string(argument));
+        if (slot == -1)
+            return commandError("No client found with account number: " + string(argument), delim);
+
+        // money commands may be changing this balance under its stripe lock
+        unique_lock<mutex> first, second;
+        lockAccountStripes(accounts, slot, -1, first, second);
+        return "OK" + delim + formatSlotAsLine(store.clients, slot, delim) + "\n";
+    }
+
+    if (command == commandList)
+    {
+        // exclusive, so no money command changes a balance while the rows are formatted
+        unique_lock<shared_mutex> writeLock(storeLock);
+        string response = "OK" + delim + to_string(store.accountIndex.live) + "\n";
+        for (size_t slot = 0; slot < slotCount(store.clients); slot++)
+        {
+            if (isSlotDeleted(store.clients, slot))
+                continue;
+            appendSlotAsLine(response, store.clients, slot, delim);
+            response += '\n';
+        }
+        return response;
+    }
+
+    if (command == commandStats)
+    {
+        shared_lock<shared_mutex> readLock(storeLock);
+        return "OK" + delim + formatCompactionStats(store, delim) + "\n";
+    }
+
+    if (command == commandAdd || command == commandUpdate)
+    {
+        sClient client;
+        string error;
+        if (!parseValidClientLine(argument, delim, client, error))
+            return commandError(error, delim);
+
+        unique_lock<shared_mutex> writeLock(storeLock);
+        if (command == commandAdd)
+        {
+            if (isAccountNumberExist(client.accountNumber, store))
+                return commandError("Account number already exists.", delim);
+
+            addClientToStore(store, client);
+            vector<sClient> vNewClients = {client};
+            if (!saveNewClients(fileName, delim, vNewClients, store))
+                return commandError("Could not save the client.", delim);
+        }
+        else if (!updateClientRecord(fileName, delim, client, store))
+            return commandError("No client found with account number: " + client.accountNumber, delim);
+        return "OK\n";
+    }
+
+    if (command == commandDeposit || command == commandWithdraw || command == commandTransfer)
+    {
+        sTransaction transaction;
+        transaction.type = (command == commandDeposit) ? Deposit : (command == commandWithdraw) ? Withdraw : Transfer;
+        string error;
+        if (!parseTransactionCommand(argument, delim, transaction, error))
+            return commandError(error, delim);
+
+        string response;
+        {
+            shared_lock<shared_mutex> readLock(storeLock);
+            enTransactionResult result = executeConcurrentTransaction(fileName, delim, accounts, transaction);
+            if (result != TransactionDone)
+                return commandError(transactionResultMessage(result), delim);
+
+            // read under the stripe lock, since other threads may be changing the same balance
+            int slot = findClientSlot(store, transaction.accountNumber);
+            unique_lock<mutex> first, second;
+            lockAccountStripes(accounts, slot, -1, first, second);
+            response = "OK" + delim + formatMoney(store.clients.balances[slot]) + "\n";
+        }
+
+        if (isConcurrentLogCompactionDue(accounts))
+        {
+            unique_lock<shared_mutex> writeLock(storeLock);
+            compactOperationLogIfNeeded(fileName, delim, store); // checks again, another thread may have compacted
+        }
+        return response;
+    }
+
+    if (command == commandDelete)
+    {
+        unique_lock<shared_mutex> writeLock(storeLock);
+        if (!deleteClientByAccNum(fileName, delim, string(argument), store))
+            return commandError("No client found with account number: " + string(argument), delim);
+        return "OK\n";
+    }
+
+    return commandError("Unknown command: " + command, delim);
+}
+
+// *****************************************************************************************************************
+
+// ------------------------------------------------------ SERVER MODE ------------------------------------------------------
+// *****************************************************************************************************************
+// The main thread accepts connections on a Unix domain socket and hands each one to a worker thread.
+// Every worker runs its own epoll loop over its connections and executes their commands in order.
+// Without epoll (anything but Linux) --server only says that it is not available.
+
+#ifdef BANK_HAS_EPOLL
+
+const size_t maxCommandLineLength = 1024 * 1024;
+
+inline volatile sig_atomic_t serverStopRequested = 0;
+
+inline void requestServerStop(int)
+{
+    serverStopRequested = 1;
+}
+
+struct sServerConnection
+{
+    string input;  // bytes received but not yet forming a complete line
+    string output; // responses not yet accepted by the socket
+    bool peerDone = false; // the client shut down its side; the connection closes once 'output' is sent
+};
+
+struct sServer
+{
+    string fileName;
+    string delim;
+    sClientStore *store = nullptr;
+    sConcurrentAccounts accounts;
+    shared_mutex storeLock;
+    vector<int> workerEpollFds;
+};
+
+inline void closeServerConnection(int epollFd, int fd, unordered_map<int, sServerConnection> &connections)
+{
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    connections.erase(fd);
+}
+
+// Writes as much pending output as the socket takes; watches for EPOLLOUT only while output is left
+// (and for input only until the client shut down its side). Returns false if the connection is broken.
+inline bool flushServerConnection(int epollFd, int fd, sServerConnection &connection)
+{
+    size_t sent = 0;
+    while (sent < connection.output.size())
+    {
+        ssize_t n = send(fd, connection.output.data() + sent, connection.output.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
+        if (n <= 0)
+            return false;
+        sent += n;
+    }
+    connection.output.erase(0, sent);
+
+    epoll_event event = {};
+    event.events = connection.peerDone ? 0 : EPOLLIN | EPOLLRDHUP;
+    if (!connection.output.empty())
+        event.events |= EPOLLOUT;
+    event.data.fd = fd;
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &event);
+    return true;
+}
+
+// Reads what is available and executes every complete command line, also after the client shut down its
+// side (pipelined commands sent just before it still get their responses). Returns false if the connection is broken.
+inline bool readServerConnection(sServer &server, int fd, sServerConnection &connection)
+{
+    char buffer[64 * 1024];
+    while (!connection.peerDone)
+    {
+        ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
+        if (n < 0)
+            return false;
+        if (n == 0)
+            connection.peerDone = true;
+        connection.input.append(buffer, n);
+    }
+
+    size_t start = 0;
+    size_t newline;
+    while ((newline = connection.input.find('\n', start)) != string::npos)
+    {
+        string_view line(connection.input.data() + start, newline - start);
+        connection.output += executeClientCommand(line, server.fileName, server.delim, server.accounts, server.storeLock);
+        start = newline + 1;
+    }
+    connection.input.erase(0, start);
+
+    return connection.input.size() <= maxCommandLineLength;
+}
+
+inline void runServerWorker(sServer &server, int epollFd)
+{
+    unordered_map<int, sServerConnection> connections;
+    epoll_event events[64];
+
+    while (!serverStopRequested)
+    {
+        int ready = epoll_wait(epollFd, events, 64, 100);
+        for (int i = 0; i < ready; i++)
+        {
+            int fd = events[i].data.fd;
+            sServerConnection &connection = connections[fd];
+
+            bool alive = true;
+            if (events[i].events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+                alive = readServerConnection(server, fd, connection);
+            if (alive)
+                alive = flushServerConnection(epollFd, fd, connection);
+            if (connection.peerDone && connection.output.empty())
+                alive = false; // every response is sent
+            if (!alive)
+                closeServerConnection(epollFd, fd, connections);
+        }
+    }
+
+    for (auto &entry : connections)
+        close(entry.first);
+    close(epollFd);
+}
+
+inline int openServerSocket(const string &socketPath)
+{
+    int listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listenFd == -1)
+        return -1;
+    if (!setNonBlocking(listenFd))
+    {
+        close(listenFd);
+        return -1;
+    }
+
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path))
+    {
+        close(listenFd);
+        return -1;
+    }
+    strcpy(address.sun_path, socketPath.c_str());
+
+    unlink(socketPath.c_str()); // a socket file left behind by a previous run
+    if (bind(listenFd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) == -1 || listen(listenFd, SOMAXCONN) == -1)
+    {
+        close(listenFd);
+        return -1;
+    }
+    return listenFd;
+}
+
+// --server: loads the store once and serves it until SIGINT / SIGTERM
+inline void runServer(string fileName, string delim, sClientStore &store, const string &socketPath, int threads)
+{
+    sServer server;
+    server.fileName = fileName;
+    server.delim = delim;
+    server.store = &store;
+    loadClientStore(fileName, delim, store);
+    initConcurrentAccounts(server.accounts, store, defaultAccountStripes);
+
+    int listenFd = openServerSocket(socketPath);
+    if (listenFd == -1)
+    {
+        cerr << "Error: Could not listen on socket '" << socketPath << "': " << strerror(errno) << "\n";
+        return;
+    }
+
+    struct sigaction action = {};
+    action.sa_handler = requestServerStop; // no SA_RESTART, so epoll_wait returns on a signal
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+
+    vector<thread> workers;
+    for (int i = 0; i < threads; i++)
+    {
+        int epollFd = epoll_create1(0);
+        server.workerEpollFds.push_back(epollFd);
+        workers.emplace_back(runServerWorker, ref(server), epollFd);
+    }
+
+    int acceptEpollFd = epoll_create1(0);
+    epoll_event listenEvent = {};
+    listenEvent.events = EPOLLIN;
+    listenEvent.data.fd = listenFd;
+    epoll_ctl(acceptEpollFd, EPOLL_CTL_ADD, listenFd, &listenEvent);
+
+    cout << "Serving " << store.accountIndex.live << " client(s) on '" << socketPath << "' with " << threads
+         << " worker thread(s). Press Ctrl+C to stop.\n";
+
+    size_t nextWorker = 0;
+    int commitWindowMs = max(1, store.operationLog.groupCommitWindowMs);
+    while (!serverStopRequested)
+    {
+        epoll_event event;
+        int ready = epoll_wait(acceptEpollFd, &event, 1, commitWindowMs);
+
+        // group commit: make the log durable once per commit window even when no new write arrives.
+        // Under the shared store lock only money commands touch the log, and they hold the log lock.
+        {
+            shared_lock<shared_mutex> readLock(server.storeLock);
+            lock_guard<mutex> logGuard(server.accounts.logLock);
+            syncOperationLog(store.operationLog);
+        }
+        {
+            // what other processes wrote may change the shape of the store, so no command runs meanwhile
+            unique_lock<shared_mutex> writeLock(server.storeLock);
+            refreshClientStore(fileName, delim, store);
+        }
+
+        if (ready <= 0)
+            continue;
+
+        int fd;
+        while ((fd = acceptNonBlocking(listenFd)) != -1)
+        {
+            epoll_event clientEvent = {};
+            clientEvent.events = EPOLLIN | EPOLLRDHUP;
+            clientEvent.data.fd = fd;
+            epoll_ctl(server.workerEpollFds[nextWorker], EPOLL_CTL_ADD, fd, &clientEvent);
+            nextWorker = (nextWorker + 1) % server.workerEpollFds.size();
+        }
+    }
+
+    for (thread &worker : workers)
+        worker.join();
+    close(acceptEpollFd);
+    close(listenFd);
+    unlink(socketPath.c_str());
+    syncOperationLog(store.operationLog);
+    cout << "\nServer stopped.\n";
+}
+
+#else
+
+inline void runServer(string, string, sClientStore &, const string &, int)
+{
+    cerr << "Error: Server mode needs epoll, which this system does not have.\n";
+}
+
+#endif
+
+// *****************************************************************************************************************
+
+// ------------------------------------------------------ BATCH MODE ------------------------------------------------------
+// *****************************************************************************************************************
+// --batch[=FILE] runs a script of command lines (the CLIENT COMMANDS above: ADD / FIND / UPDATE / DELETE / LIST
+// and the money commands) from FILE or stdin, with no prompts and no screen clearing, e.g.
+//   ADD#||#AC123#||#1234#||#Ahmed Belal#||#01012345678#||#100.50
+//   FIND#||#AC123
+// Each command's response is written to stdout in order (buffered, one write per ~1 MB); empty lines and lines
+// starting with '#' are skipped. Fields are checked with the same rules as the prompts. The summary (commands/sec
+// and failures per command) goes to stderr, so stdout holds only the responses.
+
+const size_t batchOutputBytes = 1024 * 1024;
+
+struct sBatchCommandStats
+{
+    size_t count = 0;
+    size_t failed = 0;
+};
+
+inline void runBatchCommands(string fileName, string delim, sClientStore &store, const string &scriptFileName)
+{
+    ifstream scriptFile;
+    if (scriptFileName != "-")
+    {
+        scriptFile.open(scriptFileName);
+        if (!scriptFile.is_open())
+        {
+            cerr << "Error: Could not open file '" << scriptFileName << "' for reading.\n";
+            return;
+        }
+    }
+    istream &script = (scriptFileName == "-") ? cin : scriptFile;
+
+    loadClientStore(fileName, delim, store);
+    sConcurrentAccounts accounts;
+    initConcurrentAccounts(accounts, store, defaultAccountStripes);
+    shared_mutex storeLock;
+
+    map<string, sBatchCommandStats> commandStats;
+    size_t commands = 0, failed = 0;
+    string line, output;
+    bool ok = true;
+
+    auto start = chrono::steady_clock::now();
+    chrono::milliseconds refreshInterval(max(1, store.operationLog.groupCommitWindowMs));
+    auto lastRefresh = start;
+    while (ok)
+    {
+        if (&script == &cin)
+            syncOperationLogIfIdle(store.operationLog, STDIN_FILENO); // a pipe may go quiet between commands
+        if (!getline(script, line))
+            break;
+        if (line.empty() || line == "\r" || line[0] == '#')
+            continue;
+
+        // another process may have written meanwhile; checked once per commit window, like the server does
+        auto now = chrono::steady_clock::now();
+        if (now - lastRefresh >= refreshInterval)
+        {
+            refreshClientStore(fileName, delim, store);
+            lastRefresh = now;
+        }
+        string response = executeClientCommand(line, fileName, delim, accounts, storeLock);
+        bool commandFailed = response.rfind("ERR", 0) == 0;
+
+        sBatchCommandStats &stats = commandStats[line.substr(0, min(line.find(delim), line.find('\r')))];
+        stats.count++;
+        stats.failed += commandFailed;
+        commands++;
+        failed += commandFailed;
+
+        output += response;
+        if (output.size() >= batchOutputBytes)
+        {
+            ok = writeToStdout(output);
+            output.clear();
+        }
+    }
+    syncOperationLog(store.operationLog);
+    ok = ok && writeToStdout(output);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    if (!ok)
+        cerr << "Error: Could not write the responses to stdout.\n";
+    cerr << "Batch: " << commands << " command(s) in " << fixed << setprecision(3) << seconds << " s ("
+         << setprecision(0) << (seconds > 0 ? commands / seconds : 0.0) << " commands/sec), " << failed << " failed\n";
+    for (const auto &[command, stats] : commandStats)
+        cerr << "- " << left << setw(10) << command << right << stats.count << " (" << stats.failed << " failed)\n";
+}
+
+// *****************************************************************************************************************
+
+#endif
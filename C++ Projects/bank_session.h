@@ -0,0 +1,1398 @@
+#ifndef BANK_SESSION_H
+#define BANK_SESSION_H
+
+/*
+=======================================
+Bank console session — the interactive menus
+=======================================
+
+- Main menu, input prompts with validation, client cards and tables.
+- Show Clients pages through large stores on a terminal (one write per page) and streams the whole table,
+  formatted on worker threads, when stdout is a pipe or a file.
+- Transactions menu, balance reports (SIMD reductions over the columnar balances), prefix search that
+  refreshes as you type on a terminal, and search by name.
+- The session is an explicit state machine with constant stack depth; the loaded store stays resident
+  between screens. bank_soak_test.cpp drives millions of menu transitions to check both.
+*/
+
+#include "bank_transactions.h"
+
+const string fileName = "Clients.txt";
+const string delim = "#||#";
+
+inline bool clearScreenEnabled = true; // false while a program drives the menus with scripted input (no shell per screen)
+
+inline void clearScreen()
+{
+    if (!clearScreenEnabled)
+        return;
+#ifdef _WIN32
+    system("cls");
+#else
+    system("clear");
+#endif
+}
+
+// Reads a full line string from standard input
+inline string readString(string message = "Please enter a string: ")
+{
+
+    cout << message;
+    string s;
+    getline(cin, s);
+    return s;
+}
+
+inline string sToLower(string s)
+{
+    for (char &c : s)
+    {
+        if (isupper(c))
+            tolower(c);
+    }
+
+    return s;
+}
+
+// take the confirmation from the user with yes/no
+inline bool isSure(string message = "Are you sure? (y/n) : ")
+{
+
+    cout << message << endl;
+    string answer;
+    getline(cin, answer);
+    string lowerAnswer = sToLower(answer);
+    if (!lowerAnswer.empty() && lowerAnswer[0] == 'y')
+        return true;
+
+    else
+        return false;
+}
+
+// reading an integer from the user with input validation (0 once the input has ended)
+inline short readNum(string message = "Please enter a number: ")
+{
+    while (true)
+    {
+        cout << message;
+        short n;
+        cin >> n;
+
+        if (!cin.fail() && n >= 0)
+            return n;
+        if (cin.eof())
+            return 0;
+
+        cin.clear();
+        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+        cout << "Invalid input. Please enter a valid number.\n";
+    }
+}
+
+// ------------------------------------------------------ MAIN MENU ------------------------------------------------------
+// ********************************************************************************************************************************
+
+enum enMainMenuOption
+{
+    ShowClients = 1,
+    AddClient,
+    DeleteClient,
+    UpdateClient,
+    FindClient,
+    Transactions,
+    BalanceReports,
+    PrefixSearch,
+    NameSearch,
+    Exit,
+};
+
+inline void showMainMenuOptions()
+{
+    cout << "\n========== Bank Client Manager ==========\n";
+    cout << "1. Show Clients\n";
+    cout << "2. Add New Client\n";
+    cout << "3. Delete Client\n";
+    cout << "4. Update Client\n";
+    cout << "5. Find Client\n";
+    cout << "6. Transactions\n";
+    cout << "7. Balance Reports\n";
+    cout << "8. Search by Phone / Account Prefix\n";
+    cout << "9. Search by Name\n";
+    cout << "10. Exit\n";
+    cout << "=========================================\n";
+}
+
+inline enMainMenuOption getMainMenuUserChoice()
+{
+    short choice;
+
+    short firstOptionNum = static_cast<short>(enMainMenuOption::ShowClients);
+    short lastOptionNum = static_cast<short>(enMainMenuOption::Exit);
+
+    while (true)
+    {
+        choice = readNum("Choose an option : ");
+
+        if (choice >= firstOptionNum && choice <= lastOptionNum)
+        {
+            break;
+        }
+        if (cin.eof())
+            return Exit; // the input ended: end the session as if Exit was chosen
+
+        cout << "Invalid choice. Please enter a number between " << firstOptionNum << " and " << lastOptionNum << endl;
+    }
+    enMainMenuOption enChoice = static_cast<enMainMenuOption>(choice);
+    return enChoice;
+}
+
+inline enMainMenuOption showMainScreenAndGetUserOption()
+{
+    clearScreen();
+    showMainMenuOptions();
+
+    enMainMenuOption userChoice = getMainMenuUserChoice();
+    return userChoice;
+}
+
+// Pauses until Enter; the session loop then shows the main menu again
+inline void goBackToMainMenu()
+{
+    cout << "\nPress Enter to return to the main menu...";
+    cin.get(); // Pause
+}
+
+// ********************************************************************************************************************************
+
+// ------------------------------------------------------ INPUT VALIDATION ------------------------------------------------------
+// ********************************************************************************************************************************
+
+// Each rule below has an ...Error() function that returns why a value is invalid (empty string = valid),
+// Prints the error (if any) and returns whether the value was valid
+inline bool reportValidationError(const string &error)
+{
+    if (!error.empty())
+        cout << error << "\n";
+    return error.empty();
+}
+
+// ------------- Account Number -------------
+// ------------- ------------- -------------
+
+// Error for a new account number: wrong format or already taken
+inline string newAccountNumberError(const string &accountNum, const sClientStore &store)
+{
+    string error = accountNumberFormatError(accountNum);
+    if (error.empty() && isAccountNumberExist(accountNum, store))
+        error = "Account number already exists. Please choose another.";
+    return error;
+}
+
+inline bool isValidAccountNumber(const string accountNum, sClientStore &store)
+{
+    return reportValidationError(newAccountNumberError(accountNum, store));
+}
+
+inline string readUniqueAccountNumber(sClientStore &store)
+{
+    string accountNum;
+    // Read the account number from the user and ensure that it does not already exist.
+    do
+    {
+        cout << "Account Number : ";
+        getline(cin, accountNum);
+
+    } while (cin && !isValidAccountNumber(accountNum, store)); // stop asking once the input has ended
+
+    return accountNum;
+}
+// ------------- ------------- -------------
+
+// ------------- Full Name -------------
+// ------------- ------------- -------------
+
+inline bool isValidFullName(const string &fullName)
+{
+    return reportValidationError(fullNameError(fullName));
+}
+
+inline string readFullName()
+{
+    string fullName;
+    do
+    {
+        cout << "Full Name      : ";
+        getline(cin, fullName);
+
+    } while (cin && !isValidFullName(fullName)); // stop asking once the input has ended
+
+    return fullName;
+}
+// ------------- ------------- -------------
+
+// ------------- Phone Number -------------
+// ------------- ------------- -------------
+
+inline bool isValidPhoneNumber(const string &phoneNum)
+{
+    return reportValidationError(phoneNumberError(phoneNum));
+}
+
+inline string readPhoneNumber()
+{
+    string phoneNum;
+    do
+    {
+        cout << "Phone Number   : ";
+        getline(cin, phoneNum);
+
+    } while (cin && !isValidPhoneNumber(phoneNum)); // stop asking once the input has ended
+
+    return phoneNum;
+}
+// ------------- ------------- -------------
+
+// ------------- Pin Number -------------
+// ------------- ------------- -------------
+
+inline bool isPinCodeValid(const string &pinCode)
+{
+    return reportValidationError(pinCodeError(pinCode));
+}
+
+inline string readPinCode()
+{
+    string pinCode;
+
+    do
+    {
+        cout << "PIN Code       : ";
+        getline(cin, pinCode);
+
+    } while (cin && !isPinCodeValid(pinCode)); // stop asking once the input has ended
+
+    return pinCode;
+}
+// ------------- ------------- -------------
+
+// ------------- Balance -------------
+// ------------- ------------- -------------
+
+inline bool isAccountBalanceValid(const string &accountBalance)
+{
+    return reportValidationError(accountBalanceError(accountBalance));
+}
+
+inline sMoney readAccountBalance()
+{
+    string accountBalance;
+    do
+    {
+        cout << "Account Balance: ";
+        getline(cin, accountBalance);
+
+    } while (cin && !isAccountBalanceValid(accountBalance)); // stop asking once the input has ended
+
+    sMoney balance;
+    parseMoney(accountBalance, balance);
+    return balance;
+}
+// ------------- ------------- -------------
+// ********************************************************************************************************************************
+
+// ------------------------------------------------------ DISPLAYING CLIENTS ------------------------------------------------------
+// ********************************************************************************************************************************
+
+// Prints all fields of a single client in a formatted layout
+inline void displayClientCard(const sClient client)
+{
+    cout << "---------------------------------------------\n";
+    cout << "Account Number : " << client.accountNumber << "\n";
+    cout << "Pin Code       : " << client.pinCode << "\n";
+    cout << "Full Name      : " << client.fullName << "\n";
+    cout << "Phone          : " << client.phone << "\n";
+    cout << "Balance        : " << client.accountBalance << "\n";
+    cout << "---------------------------------------------\n";
+}
+
+inline void displayClientRecord(const sClient client, int n)
+{
+    cout << "| " << setw(5) << left << n;
+    cout << "| " << setw(15) << left << client.accountNumber;
+    cout << "| " << setw(10) << left << client.pinCode;
+    cout << "| " << setw(40) << left << client.fullName;
+    cout << "| " << setw(12) << left << client.phone;
+
+    cout << "| " << setw(12) << left << client.accountBalance;
+}
+
+inline void printHorizontalTableBorder()
+{
+    cout << "\n_______________________________________________________";
+    cout << "__________________________________________________\n\n";
+}
+
+inline void printTableHeader()
+{
+    printHorizontalTableBorder();
+    cout << "| " << left << setw(5) << "Num";
+    cout << "| " << left << setw(15) << "Account Number";
+    cout << "| " << left << setw(10) << "Pin Code";
+    cout << "| " << left << setw(40) << "Client Name";
+    cout << "| " << left << setw(12) << "Phone";
+    cout << "| " << left << setw(12) << "Balance";
+    printHorizontalTableBorder();
+}
+
+// Iterates through a list of clients and prints each one using displayClientCard
+// (clients marked for delete are skipped)
+inline void displayClientsStructFromVector(vector<sClient> &vClients)
+{
+
+    int n = 1;
+    size_t liveClients = count_if(vClients.begin(), vClients.end(), [](const sClient &client)
+                                  { return !client.markedForDelete; });
+    cout << "\n\t\t\t\t\tClient List (" << liveClients << ") Client(s).\n";
+
+    printTableHeader();
+
+    // print clients inside the table
+    for (sClient &client : vClients)
+    {
+        if (client.markedForDelete)
+            continue;
+
+        displayClientRecord(client, n);
+        if (n < liveClients)
+            cout << endl;
+        n++;
+    }
+    printHorizontalTableBorder();
+}
+
+// ------------- Paged Listing -------------
+// ------------- ------------- -------------
+// "Show Clients" on a terminal shows one page of rows at a time; each page (header, rows, footer) is
+// formatted into one reused buffer and written with a single write(). When stdout is not a terminal
+// (a pipe or a file) the whole table is streamed instead: worker threads format consecutive chunks of
+// rows in parallel and the chunks are written in order.
+
+const size_t exportChunkRows = 16384;
+
+// Appends 'text' left-aligned in a column of 'width' characters (like setw(width) << left)
+inline void appendTableCell(string &buffer, string_view text, size_t width)
+{
+    buffer.append("| ");
+    buffer.append(text);
+    if (text.size() < width)
+        buffer.append(width - text.size(), ' ');
+}
+
+// Same row as displayClientRecord for the client in 'slot', appended to a buffer
+inline void appendClientRow(string &buffer, const sClientSlots &slots, size_t slot, size_t n)
+{
+    char number[24];
+    char *numberEnd = to_chars(number, number + sizeof(number), n).ptr;
+    char balance[moneyTextCapacity];
+    char *balanceEnd = formatMoneyTo(balance, slots.balances[slot]);
+
+    appendTableCell(buffer, string_view(number, numberEnd - number), 5);
+    appendTableCell(buffer, slotAccountNumber(slots, slot), 15);
+    appendTableCell(buffer, compactPinCode(slots.records[slot]), 10);
+    appendTableCell(buffer, slotFullName(slots, slot), 40);
+    appendTableCell(buffer, compactPhone(slots.records[slot]), 12);
+    appendTableCell(buffer, string_view(balance, balanceEnd - balance), 12);
+    buffer += '\n';
+}
+
+inline void appendHorizontalTableBorder(string &buffer)
+{
+    buffer.append("\n_______________________________________________________");
+    buffer.append("__________________________________________________\n\n");
+}
+
+// Same header as printTableHeader, appended to a buffer
+inline void appendTableHeader(string &buffer)
+{
+    appendHorizontalTableBorder(buffer);
+    appendTableCell(buffer, "Num", 5);
+    appendTableCell(buffer, "Account Number", 15);
+    appendTableCell(buffer, "Pin Code", 10);
+    appendTableCell(buffer, "Client Name", 40);
+    appendTableCell(buffer, "Phone", 12);
+    appendTableCell(buffer, "Balance", 12);
+    appendHorizontalTableBorder(buffer);
+}
+
+// Slots of the clients that are not marked for delete, in listing order
+inline vector<uint32_t> listLiveSlots(const sClientSlots &slots)
+{
+    vector<uint32_t> vSlots;
+    vSlots.reserve(slotCount(slots));
+    for (size_t slot = 0; slot < slotCount(slots); slot++)
+    {
+        if (!isSlotDeleted(slots, slot))
+            vSlots.push_back(static_cast<uint32_t>(slot));
+    }
+    return vSlots;
+}
+
+// Formats one page into 'buffer' (cleared first, its capacity kept between pages)
+inline void formatClientPage(string &buffer, const sClientSlots &slots, const vector<uint32_t> &vSlots, size_t page, size_t pageRows)
+{
+    size_t pages = max<size_t>(1, (vSlots.size() + pageRows - 1) / pageRows);
+    size_t first = page * pageRows;
+    size_t end = min(vSlots.size(), first + pageRows);
+
+    buffer.clear();
+    buffer.append("\n\t\t\t\t\tClient List (").append(to_string(vSlots.size())).append(") Client(s).\n");
+    appendTableHeader(buffer);
+    for (size_t row = first; row < end; row++)
+        appendClientRow(buffer, slots, vSlots[row], row + 1);
+    if (end > first)
+        buffer.pop_back(); // the border starts on the line of the last row, as in displayClientsStructFromVector
+    appendHorizontalTableBorder(buffer);
+    buffer.append("Page ").append(to_string(page + 1)).append(" of ").append(to_string(pages));
+    buffer.append("   [Enter/n] next  [p] previous  [g N] go to page N  [q] back: ");
+}
+
+// Interactive pages of 'pageRows' rows; returns when the user quits or input ends
+inline void showClientPages(const sClientSlots &slots, size_t pageRows)
+{
+    vector<uint32_t> vSlots = listLiveSlots(slots);
+    size_t pages = max<size_t>(1, (vSlots.size() + pageRows - 1) / pageRows);
+    size_t page = 0;
+    string buffer;
+    string command;
+
+    while (true)
+    {
+        formatClientPage(buffer, slots, vSlots, page, pageRows);
+        if (!writeToStdout(buffer) || !getline(cin, command) || command == "q" || command == "Q")
+            break;
+
+        if (command.empty() || command == "n" || command == "N")
+        {
+            if (page + 1 < pages)
+                page++;
+        }
+        else if (command == "p" || command == "P")
+        {
+            if (page > 0)
+                page--;
+        }
+        else if (command[0] == 'g' || command[0] == 'G')
+        {
+            size_t target = 0;
+            string_view number = string_view(command).substr(1);
+            while (!number.empty() && number.front() == ' ')
+                number.remove_prefix(1);
+            if (from_chars(number.data(), number.data() + number.size(), target).ec == errc() && target >= 1)
+                page = min(target, pages) - 1;
+        }
+    }
+    cout << "\n";
+}
+
+// Streams the whole table to stdout: rounds of one chunk per thread are formatted in parallel,
+// then written in order, so memory stays at 'threads' chunks however many clients there are
+inline void exportClientTable(const sClientSlots &slots, int threads)
+{
+    vector<uint32_t> vSlots = listLiveSlots(slots);
+    size_t workers = max(1, threads);
+    vector<string> vChunks(workers);
+
+    string header = "\n\t\t\t\t\tClient List (" + to_string(vSlots.size()) + ") Client(s).\n";
+    appendTableHeader(header);
+    bool ok = writeToStdout(header);
+
+    for (size_t first = 0; ok && first < vSlots.size(); first += workers * exportChunkRows)
+    {
+        auto formatChunk = [&](size_t chunk)
+        {
+            string &buffer = vChunks[chunk];
+            buffer.clear();
+            size_t begin = first + chunk * exportChunkRows;
+            size_t end = min(vSlots.size(), begin + exportChunkRows);
+            for (size_t row = begin; row < end; row++)
+                appendClientRow(buffer, slots, vSlots[row], row + 1);
+        };
+
+        vector<thread> vThreads;
+        for (size_t chunk = 1; chunk < workers; chunk++)
+            vThreads.emplace_back(formatChunk, chunk);
+        formatChunk(0);
+        for (thread &worker : vThreads)
+            worker.join();
+
+        for (size_t chunk = 0; ok && chunk < workers; chunk++)
+            ok = writeToStdout(vChunks[chunk]);
+    }
+
+    string footer;
+    appendHorizontalTableBorder(footer);
+    if (!vSlots.empty())
+        footer.erase(0, 1); // the last row already ended the line
+    if (ok)
+        writeToStdout(footer);
+}
+
+// Show Clients: pages on a terminal, the whole table streamed otherwise
+inline void showClientList(sClientStore &store)
+{
+    if (isatty(STDOUT_FILENO))
+        showClientPages(store.clients, store.listingPageRows);
+    else
+        exportClientTable(store.clients, store.loaderThreads);
+}
+// ********************************************************************************************************************************
+
+// Reads client details from user input to construct a complete sClient record
+// returns a Client object
+inline sClient readClientInfoFromUser(short n, sClientStore &store)
+{
+    sClient client;
+    cout << "\nEntering details for Client [" << n << "]\n";
+
+    // Read the account number from the user and ensure that it does not already exist.
+    client.accountNumber = readUniqueAccountNumber(store);
+
+    client.pinCode = readPinCode();
+
+    client.fullName = readFullName();
+
+    client.phone = readPhoneNumber();
+
+    client.accountBalance = readAccountBalance();
+
+    return client;
+}
+
+// returns a Client object
+inline sClient ChangeClientInfoFromUser(string accountNumber)
+
+{
+    sClient client;
+    cout << "Updating client details for client:[ " << accountNumber << " ]\n";
+
+    // Read the account number from the user and ensure that it does not already exist.
+    client.accountNumber = accountNumber;
+
+    client.pinCode = readPinCode();
+
+    client.fullName = readFullName();
+
+    client.phone = readPhoneNumber();
+
+    client.accountBalance = readAccountBalance();
+
+    return client;
+}
+
+// DISPLAYING CLIENTS AS LINES NOT CARDS (POTENTIAL DELETION)
+// ********************************************************************************************
+
+// Outputs all clients in delimited-line format for data export or file writing
+inline void displayClientsAsLines(vector<sClient> &vClients, string delim)
+{
+
+    short n = 1;
+    for (sClient &client : vClients)
+    {
+        cout << "----------------------------------\n";
+        cout << "Client [" << n++ << "]\n";
+        string clientRecord = formatClientAsLine(client, delim);
+        cout << clientRecord << endl;
+        cout << "----------------------------------\n";
+    }
+}
+
+// ********************************************************************************************
+
+// ------------------------------------------------------ ADDING NEW CLIENTS  ------------------------------------------------------
+// *****************************************************************************************************************
+
+//  multiple clients from user input and stores them in the client store
+inline void inputMultipleClients(int numOfClients, sClientStore &store)
+{
+    for (short n = 1; n <= numOfClients; ++n)
+    {
+        // Prompt user to input details for client n
+        sClient client = readClientInfoFromUser(n, store);
+        addClientToStore(store, client);
+    }
+
+    // Display all collected client records in formatted structure
+    vector<sClient> vClients;
+    for (size_t slot = 0; slot < slotCount(store.clients); slot++)
+        vClients.push_back(clientAtSlot(store.clients, slot));
+    displayClientsStructFromVector(vClients);
+}
+
+// Returns false (and adds nothing) when the input ended before the client was complete
+inline bool addIndividualClient(sClientStore &store, vector<sClient> &vNewClients, int n)
+{
+    // Prompt user to input details for client n
+    sClient client = readClientInfoFromUser(n, store);
+    if (!cin)
+        return false;
+    vNewClients.push_back(client);
+    // add this client to the store (and its index) so the next account number is checked against it
+    addClientToStore(store, client);
+    return true;
+}
+
+// Collects client data through separate prompts, stores them,
+// then prints all records in a single delimited-line format
+inline void AddNewClient(string fileName, string delim, sClientStore &store)
+{
+
+    vector<sClient> vNewClients;
+    int n = 0;
+    do
+    {
+        if (!addIndividualClient(store, vNewClients, n + 1))
+            break;
+        n++;
+
+    } while (isSure("Do you want to add a new client?:(y/n): "));
+
+    if (vNewClients.empty())
+        return;
+
+    if (!saveNewClients(fileName, delim, vNewClients, store))
+    {
+        cout << "Error: the clients could not be saved. Clients that were not saved have been discarded.\n";
+        return;
+    }
+    cout << "Client" << (n == 1 ? "" : "s") << " " << (n == 1 ? "has" : "have") << " been added successfully. " << endl;
+    cout << "\n\t\t\t\t\t----[ADDED CLIENTS]----\n";
+    displayClientsStructFromVector(vNewClients);
+}
+
+// *****************************************************************************************************************
+
+// ------------------------------------------------------ FIND, UPDATE & DELETE ------------------------------------------------------
+// *****************************************************************************************************************
+
+inline void removeClientFromFileByAccNum(string fileName, string delim, string accountNumber, sClientStore &store)
+{
+    sClient client;
+    if (findClientInFileByAccountNum(fileName, delim, accountNumber, store, client))
+    {
+
+        cout << "\n- Client Details:\n";
+        displayClientCard(client);
+
+        if (isSure("Are you sure you want to delete this client? (y/n) : "))
+        {
+
+            // mark the client as deleted and append a DELETE record to the log
+            if (deleteClientByAccNum(fileName, delim, accountNumber, store))
+            {
+                cout << "Client with account number: [" << client.accountNumber << "] has been deleted successfully!\n";
+            }
+            else
+                cout << "Client [" << accountNumber << "] not found!\n";
+        }
+    }
+
+    else
+        cout << "No client found with account number: " << accountNumber << "\n";
+}
+
+// Updates a client record in the file by account number
+inline void updateClientInFileByAccountNumber(string accountNumber, string fileName, string delim, sClientStore &store)
+{
+    // Step 1: Search for the client in the file and load all clients into the store
+    sClient client;
+    if (findClientInFileByAccountNum(fileName, delim, accountNumber, store, client))
+    {
+        cout << "\n- Client Details:\n";
+        displayClientCard(client);
+
+        // Confirm with the user before applying changes
+        if (!isSure("Are you sure you want to update this client? (y/n): "))
+            return;
+
+        // Step 2: Prompt for and collect updated client information
+        sClient updatedClient = ChangeClientInfoFromUser(accountNumber);
+        if (!cin)
+            return; // the input ended before every field was entered
+
+        // Step 3: Replace the old record in place (its slot and index entry stay the same)
+        //         and append an UPDATE record to the log instead of rewriting the file
+        updateClientRecord(fileName, delim, updatedClient, store);
+
+        cout << "Client updated successfully.\n";
+    }
+    else
+    {
+        cout << "No client found with account number: " << accountNumber << "\n";
+    }
+}
+
+// *****************************************************************************************************************
+
+// ------------- Transactions Menu -------------
+// ------------- ------------- -------------
+
+enum enTransactionsMenuOption
+{
+    DepositOption = 1,
+    WithdrawOption,
+    TransferOption,
+    MainMenuOption,
+};
+
+inline void showTransactionsMenuOptions()
+{
+    cout << "\n============ Transactions Menu ============\n";
+    cout << "1. Deposit\n";
+    cout << "2. Withdraw\n";
+    cout << "3. Transfer\n";
+    cout << "4. Main Menu\n";
+    cout << "===========================================\n";
+}
+
+inline enTransactionsMenuOption getTransactionsMenuUserChoice()
+{
+    short choice;
+    while (true)
+    {
+        choice = readNum("Choose an option : ");
+        if (choice >= DepositOption && choice <= MainMenuOption)
+            break;
+        if (cin.eof())
+            return MainMenuOption;
+        cout << "Invalid choice. Please enter a number between " << DepositOption << " and " << MainMenuOption << endl;
+    }
+    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+    return static_cast<enTransactionsMenuOption>(choice);
+}
+
+inline sMoney readTransactionAmount()
+{
+    string amount;
+    sMoney money;
+    while (true)
+    {
+        cout << "Amount         : ";
+        if (!getline(cin, amount))
+            return money; // the input ended: 0, which the confirmation below never gets to
+        if (!isAccountBalanceValid(amount))
+            continue;
+        parseMoney(amount, money);
+        if (money > sMoney{})
+            return money;
+        cout << "Amount must be at least 0.01.\n";
+    }
+}
+
+// Reads an account number until it names an existing client, whose card is shown
+inline string readExistingAccountNumber(sClientStore &store, string message)
+{
+    while (true)
+    {
+        string accountNumber = readString(message);
+        if (!cin)
+            return accountNumber; // the input ended, the caller's confirmation fails
+        int slot = findClientSlot(store, accountNumber);
+        if (slot != -1)
+        {
+            displayClientCard(clientAtSlot(store.clients, slot));
+            return accountNumber;
+        }
+        cout << "No client found with account number: " << accountNumber << "\n";
+    }
+}
+
+inline void performTransactionFromUser(string fileName, string delim, sClientStore &store, enTransactionType type)
+{
+    sTransaction transaction;
+    transaction.type = type;
+
+    transaction.accountNumber = readExistingAccountNumber(store, type == Transfer ? "Transfer from account number: " : "Please enter account number: ");
+    if (type == Transfer)
+        transaction.toAccountNumber = readExistingAccountNumber(store, "Transfer to account number: ");
+    transaction.amount = readTransactionAmount();
+
+    if (!isSure("Are you sure you want to perform this transaction? (y/n): "))
+        return;
+
+    enTransactionResult result = executeTransaction(fileName, delim, store, transaction);
+    cout << transactionResultMessage(result) << "\n";
+    if (result == TransactionDone)
+    {
+        cout << "New Balance    : " << store.clients.balances[findClientSlot(store, transaction.accountNumber)] << "\n";
+    }
+}
+
+inline void showTransactionsMenu(string fileName, string delim, sClientStore &store)
+{
+    if (slotCount(store.clients) == 0)
+        loadClientStore(fileName, delim, store);
+
+    while (true)
+    {
+        clearScreen();
+        showTransactionsMenuOptions();
+        enTransactionsMenuOption option = getTransactionsMenuUserChoice();
+        if (option == MainMenuOption)
+            return;
+
+        performTransactionFromUser(fileName, delim, store, static_cast<enTransactionType>(option));
+        syncOperationLogIfIdle(store.operationLog, STDIN_FILENO);
+        cout << "\nPress Enter to return to the transactions menu...";
+        cin.get();
+    }
+}
+// ------------- ------------- -------------
+
+// *****************************************************************************************************************
+
+// ------------------------------------------------------ BALANCE REPORTS ------------------------------------------------------
+// ********************************************************************************************************************************
+// Aggregates run over store.columns.balances (one contiguous array of cents), 8 balances per AVX2 iteration.
+// Integer sums are exact, so the total is the same whichever path computed it.
+
+struct sBalanceSummary
+{
+    size_t count = 0;
+    long long total = 0;
+    long long minBalance = 0;
+    long long maxBalance = 0;
+};
+
+inline sBalanceSummary summarizeBalancesScalar(const long long *balances, size_t n)
+{
+    sBalanceSummary summary;
+    summary.count = n;
+    if (n == 0)
+        return summary;
+
+    summary.minBalance = summary.maxBalance = balances[0];
+    for (size_t i = 0; i < n; i++)
+    {
+        summary.total += balances[i];
+        summary.minBalance = min(summary.minBalance, balances[i]);
+        summary.maxBalance = max(summary.maxBalance, balances[i]);
+    }
+    return summary;
+}
+
+inline size_t countBalancesAboveScalar(const long long *balances, size_t n, long long threshold)
+{
+    size_t count = 0;
+    for (size_t i = 0; i < n; i++)
+        count += (balances[i] > threshold);
+    return count;
+}
+
+#ifdef BANK_X86_SIMD
+inline bool cpuSupportsAvx2()
+{
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+}
+
+__attribute__((target("avx2"))) long long horizontalSum(__m256i v)
+{
+    long long lanes[4];
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(lanes), v);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+
+// AVX2 has no 64-bit min/max, so they are a compare plus a blend
+__attribute__((target("avx2"))) __m256i minimumEpi64(__m256i a, __m256i b)
+{
+    return _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(a, b));
+}
+
+__attribute__((target("avx2"))) __m256i maximumEpi64(__m256i a, __m256i b)
+{
+    return _mm256_blendv_epi8(a, b, _mm256_cmpgt_epi64(b, a));
+}
+
+__attribute__((target("avx2"))) sBalanceSummary summarizeBalancesAvx2(const long long *balances, size_t n)
+{
+    if (n < 8)
+        return summarizeBalancesScalar(balances, n);
+
+    // two independent accumulators hide the latency of the vector adds
+    __m256i sum0 = _mm256_setzero_si256(), sum1 = _mm256_setzero_si256();
+    __m256i minimum = _mm256_set1_epi64x(balances[0]), maximum = minimum;
+
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(balances + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(balances + i + 4));
+        sum0 = _mm256_add_epi64(sum0, a);
+        sum1 = _mm256_add_epi64(sum1, b);
+        minimum = minimumEpi64(minimum, minimumEpi64(a, b));
+        maximum = maximumEpi64(maximum, maximumEpi64(a, b));
+    }
+
+    long long lanes[4];
+    sBalanceSummary summary = summarizeBalancesScalar(balances + i, n - i);
+    summary.total += horizontalSum(_mm256_add_epi64(sum0, sum1));
+
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(lanes), minimum);
+    long long lowest = min(min(lanes[0], lanes[1]), min(lanes[2], lanes[3]));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(lanes), maximum);
+    long long highest = max(max(lanes[0], lanes[1]), max(lanes[2], lanes[3]));
+
+    summary.minBalance = (summary.count == 0) ? lowest : min(summary.minBalance, lowest);
+    summary.maxBalance = (summary.count == 0) ? highest : max(summary.maxBalance, highest);
+    summary.count = n;
+    return summary;
+}
+
+__attribute__((target("avx2,popcnt"))) size_t countBalancesAboveAvx2(const long long *balances, size_t n, long long threshold)
+{
+    __m256i limit = _mm256_set1_epi64x(threshold);
+    size_t count = 0;
+
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256i a = _mm256_cmpgt_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(balances + i)), limit);
+        __m256i b = _mm256_cmpgt_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(balances + i + 4)), limit);
+        int maskA = _mm256_movemask_pd(_mm256_castsi256_pd(a));
+        int maskB = _mm256_movemask_pd(_mm256_castsi256_pd(b));
+        count += __builtin_popcount(maskA | (maskB << 4));
+    }
+    return count + countBalancesAboveScalar(balances + i, n - i, threshold);
+}
+#endif
+
+inline sBalanceSummary summarizeBalances(const vector<long long> &balances)
+{
+#ifdef BANK_X86_SIMD
+    if (cpuSupportsAvx2())
+        return summarizeBalancesAvx2(balances.data(), balances.size());
+#endif
+    return summarizeBalancesScalar(balances.data(), balances.size());
+}
+
+inline size_t countBalancesAbove(const vector<long long> &balances, long long threshold)
+{
+#ifdef BANK_X86_SIMD
+    if (cpuSupportsAvx2())
+        return countBalancesAboveAvx2(balances.data(), balances.size(), threshold);
+#endif
+    return countBalancesAboveScalar(balances.data(), balances.size(), threshold);
+}
+
+// Nearest-rank percentiles (0-100) of the balances, selected with nth_element on one copy of the column
+inline vector<long long> balancePercentiles(const vector<long long> &balances, const vector<double> &percents)
+{
+    vector<long long> values(percents.size(), 0);
+    if (balances.empty())
+        return values;
+
+    vector<long long> sorted = balances;
+    auto begin = sorted.begin();
+    for (size_t i = 0; i < percents.size(); i++)
+    {
+        // percents are ascending, so each selection only has to look right of the previous one
+        size_t rank = static_cast<size_t>(percents[i] / 100.0 * sorted.size() + 0.999999);
+        auto nth = sorted.begin() + (rank == 0 ? 0 : rank - 1);
+        nth_element(begin, nth, sorted.end());
+        values[i] = *nth;
+        begin = nth;
+    }
+    return values;
+}
+
+inline void showBalanceReports(sClientStore &store)
+{
+    const vector<long long> &balances = store.columns.balances;
+    const vector<double> percents = {25, 50, 75, 90, 99};
+
+    auto start = chrono::steady_clock::now();
+    sBalanceSummary summary = summarizeBalances(balances);
+    vector<long long> percentiles = balancePercentiles(balances, percents);
+    chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+
+    cout << "---------------------------------------------\n";
+    cout << "Clients        : " << summary.count << "\n";
+    cout << "Total Balance  : " << sMoney{summary.total} << "\n";
+    cout << "Mean Balance   : " << sMoney{summary.count ? llround(static_cast<double>(summary.total) / summary.count) : 0} << "\n";
+    cout << "Min Balance    : " << sMoney{summary.minBalance} << "\n";
+    cout << "Max Balance    : " << sMoney{summary.maxBalance} << "\n";
+    for (size_t i = 0; i < percents.size(); i++)
+        cout << "P" << left << setw(14) << static_cast<int>(percents[i]) << ": " << sMoney{percentiles[i]} << "\n";
+    cout << "---------------------------------------------\n";
+    cout << "(computed in " << fixed << setprecision(2) << elapsed.count() << " ms)\n\n";
+
+    string threshold;
+    do
+    {
+        cout << "Count clients with balance above: ";
+        getline(cin, threshold);
+
+    } while (cin && !isAccountBalanceValid(threshold));
+
+    sMoney limit;
+    parseMoney(threshold, limit);
+    start = chrono::steady_clock::now();
+    size_t above = countBalancesAbove(balances, limit.cents);
+    elapsed = chrono::steady_clock::now() - start;
+    cout << above << " client(s) have a balance above " << threshold << " (computed in " << elapsed.count() << " ms)\n";
+}
+
+// ********************************************************************************************************************************
+
+// ------------------------------------------------------ PREFIX SEARCH ------------------------------------------------------
+// ********************************************************************************************************************************
+// Search by the first digits of a phone number or account number. On a terminal the results are redrawn
+// after every key press (Tab switches the field, Backspace deletes, Enter finishes); with piped input
+// one field choice and one prefix line are read instead.
+
+const size_t prefixSearchResults = 10;
+
+inline string prefixFieldName(enPrefixField field)
+{
+    return field == PrefixPhone ? "Phone" : "Account Number";
+}
+
+// Prints the first matches for the prefix and how long the lookup took
+inline void showPrefixMatches(const sClientStore &store, enPrefixField field, const string &prefix)
+{
+    const sPrefixIndex &index = (field == PrefixPhone) ? store.phoneIndex : store.accountPrefixIndex;
+
+    auto start = chrono::steady_clock::now();
+    vector<int> slots = findByPrefix(store, index, prefix, prefixSearchResults);
+    chrono::duration<double, micro> elapsed = chrono::steady_clock::now() - start;
+
+    cout << "First " << slots.size() << " match(es) by " << prefixFieldName(field) << " (" << fixed << setprecision(0)
+         << elapsed.count() << " us)";
+    printTableHeader();
+    for (size_t i = 0; i < slots.size(); i++)
+    {
+        displayClientRecord(clientAtSlot(store.clients, slots[i]), static_cast<int>(i + 1));
+        cout << "\n";
+    }
+    printHorizontalTableBorder();
+}
+
+// As-you-type search on a terminal in raw key mode: the screen is redrawn after each key press
+inline void runInteractivePrefixSearch(const sClientStore &store)
+{
+    enPrefixField field = PrefixPhone;
+    string prefix;
+    while (true)
+    {
+        cout << "\033[H\033[J"; // cursor home + clear, far cheaper than clearScreen() on every key
+        cout << "Search by " << prefixFieldName(field) << " (Tab: switch field, Enter: done)\n> " << prefix << "\n\n";
+        showPrefixMatches(store, field, prefix);
+        cout << flush;
+
+        char key;
+        if (read(STDIN_FILENO, &key, 1) != 1 || key == '\n' || key == '\r' || key == 27)
+            break;
+        if (key == '\t')
+            field = (field == PrefixPhone) ? PrefixAccountNumber : PrefixPhone;
+        else if (key == 127 || key == '\b')
+        {
+            if (!prefix.empty())
+                prefix.pop_back();
+        }
+        else if (isprint(static_cast<unsigned char>(key)))
+            prefix += key;
+    }
+}
+
+inline void showPrefixSearch(string fileName, string delim, sClientStore &store)
+{
+    if (!store.loaded)
+        loadClientStore(fileName, delim, store);
+
+#ifdef BANK_HAS_TERMIOS
+    termios saved;
+    if (isatty(STDIN_FILENO) && beginRawKeyInput(saved))
+    {
+        runInteractivePrefixSearch(store);
+        endRawKeyInput(saved);
+        return;
+    }
+#endif
+
+    enPrefixField field = (readNum("Search by (1) Phone or (2) Account Number: ") == 2) ? PrefixAccountNumber : PrefixPhone;
+    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+    string prefix = readString("Please enter the first digits: ");
+    showPrefixMatches(store, field, prefix);
+}
+
+// ********************************************************************************************************************************
+
+// ------------------------------------------------------ NAME SEARCH ------------------------------------------------------
+// ********************************************************************************************************************************
+// Typo-tolerant search by full name through the trigram index: a query matches a client if it is
+// within a few edits of some part of the name ("ahmad bela" finds "Ahmed Belal").
+
+const size_t nameSearchResults = 10;
+
+// One typo allowed per 4 characters of the query, at most 3
+inline int allowedNameEdits(const string &query)
+{
+    return min(3, max(1, static_cast<int>(query.size()) / 4));
+}
+
+inline void showNameSearch(string fileName, string delim, sClientStore &store)
+{
+    if (!store.loaded)
+        loadClientStore(fileName, delim, store);
+
+    string query = readString("Please enter the name (or part of it): ");
+    int maxEdits = allowedNameEdits(query);
+
+    auto start = chrono::steady_clock::now();
+    vector<sNameMatch> matches = findByName(store, query, maxEdits, nameSearchResults);
+    chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+
+    cout << "\n"
+         << matches.size() << " closest match(es) with up to " << maxEdits << " typo(s) (" << fixed << setprecision(2)
+         << elapsed.count() << " ms)";
+    printTableHeader();
+    for (size_t i = 0; i < matches.size(); i++)
+    {
+        displayClientRecord(clientAtSlot(store.clients, matches[i].slot), static_cast<int>(i + 1));
+        cout << "| " << matches[i].distance << " typo(s)\n";
+    }
+    printHorizontalTableBorder();
+}
+
+// ********************************************************************************************************************************
+
+// -------------------------------------------------- DISPLAYING SCREEN FOR EACH OPTION ------------------------------------------------------
+// ********************************************************************************************************************************
+inline void showClientsRecordScreen(sClientStore &store, string fileName, string delim)
+{
+
+    cout << "\n\t\t\t\t==========================================\n";
+    cout << "\t\t\t\t === Bank Client Manager: ALL CLIENTS ===\n";
+    cout << "\t\t\t\t==========================================\n";
+}
+
+inline void showAddClientScreen()
+
+{
+    cout << "\n\t\t\t\t==========================================\n";
+    cout << "\t\t\t\t === Bank Client Manager: ADDING CLIENT ===\n";
+    cout << "\t\t\t\t==========================================\n";
+}
+
+inline void showDeleteClientScreen()
+{
+
+    cout << "\n\t\t\t\t==========================================\n";
+    cout << "\t\t\t\t === Bank Client Manager: DELETE CLIENT ===\n";
+    cout << "\t\t\t\t==========================================\n";
+}
+
+inline void showUpdateClientScreen()
+{
+    cout << "\n\t\t\t\t==========================================\n";
+    cout << "\t\t\t\t === Bank Client Manager: UPDATE CLIENT ===\n";
+    cout << "\t\t\t\t==========================================\n";
+}
+
+inline void showFindClientScreen()
+{
+    cout << "\n\t\t\t\t==========================================\n";
+    cout << "\t\t\t\t === Bank Client Manager: FIND CLIENT ===\n";
+    cout << "\t\t\t\t==========================================\n\n";
+}
+
+// ********************************************************************************************************************************
+
+inline void showBalanceReportsScreen()
+{
+    cout << "\n\t\t\t\t==========================================\n";
+    cout << "\t\t\t\t === Bank Client Manager: BALANCE REPORTS ===\n";
+    cout << "\t\t\t\t==========================================\n\n";
+}
+
+inline void showPrefixSearchScreen()
+{
+    cout << "\n\t\t\t\t==========================================\n";
+    cout << "\t\t\t\t === Bank Client Manager: PREFIX SEARCH ===\n";
+    cout << "\t\t\t\t==========================================\n\n";
+}
+
+inline void showNameSearchScreen()
+{
+    cout << "\n\t\t\t\t==========================================\n";
+    cout << "\t\t\t\t === Bank Client Manager: SEARCH BY NAME ===\n";
+    cout << "\t\t\t\t==========================================\n\n";
+}
+
+inline void showEndScreen()
+{
+    cout << "\n___________________________\n\n";
+    cout << "Program Ends..\n";
+    cout << "___________________________\n";
+}
+
+// ------------------------------------------------------ SESSION ------------------------------------------------------
+// ********************************************************************************************************************************
+// The interactive session is a loop over explicit states. handleProgram runs one screen and returns the next
+// state instead of calling back into the menu (which used to add stack frames on every round trip until Exit),
+// so the stack depth stays the same however long the session runs. The store stays loaded between screens.
+
+enum enSessionState
+{
+    MainMenuState = 1, // show the main menu and read a choice
+    OptionState,       // run the chosen screen
+    PauseState,        // "Press Enter to return to the main menu..."
+    EndState,
+};
+
+struct sSession
+{
+    enSessionState state = MainMenuState;
+    enMainMenuOption choice = Exit;
+    size_t transitions = 0;
+};
+
+// Runs the screen of one main menu option and returns the state the session goes to next
+inline enSessionState handleProgram(enMainMenuOption enUserChoice, sClientStore &store)
+{
+    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+
+    switch (enUserChoice)
+    {
+
+    case ShowClients:
+        clearScreen();
+        showAddClientScreen();
+        ensureClientStoreLoaded(fileName, delim, store);
+        showClientList(store);
+        return PauseState;
+
+    case AddClient:
+        clearScreen();
+        showAddClientScreen();
+        // adding existing clients to the store for checking account Number
+        ensureClientStoreLoaded(fileName, delim, store);
+        AddNewClient(fileName, delim, store);
+        return PauseState;
+
+    case DeleteClient:
+    {
+        clearScreen();
+
+        showDeleteClientScreen();
+        string accountNumber = readString("Please enter account number: ");
+        removeClientFromFileByAccNum(fileName, delim, accountNumber, store);
+        return PauseState;
+    }
+
+    case UpdateClient:
+    {
+        clearScreen();
+        showUpdateClientScreen();
+
+        string accountNumber = readString("Please enter account number: ");
+        updateClientInFileByAccountNumber(accountNumber, fileName, delim, store);
+        return PauseState;
+    }
+
+    case FindClient:
+    {
+        clearScreen();
+        showFindClientScreen();
+        string accountNumber = readString("Please enter account number: ");
+        sClient client;
+        if (findClientInFileByAccountNum(fileName, delim, accountNumber, store, client))
+        {
+
+            cout << "• Client Details: \n";
+            displayClientCard(client);
+        }
+        else
+        {
+            cout << "No client found with account number: " << accountNumber << "\n";
+        }
+        return PauseState;
+    }
+
+    case Transactions:
+        showTransactionsMenu(fileName, delim, store);
+        return MainMenuState;
+
+    case BalanceReports:
+    {
+        clearScreen();
+        showBalanceReportsScreen();
+        ensureClientStoreLoaded(fileName, delim, store);
+        showBalanceReports(store);
+        return PauseState;
+    }
+
+    case PrefixSearch:
+    {
+        clearScreen();
+        showPrefixSearchScreen();
+        showPrefixSearch(fileName, delim, store);
+        return PauseState;
+    }
+
+    case NameSearch:
+    {
+        clearScreen();
+        showNameSearchScreen();
+        showNameSearch(fileName, delim, store);
+        return PauseState;
+    }
+
+    case Exit:
+        clearScreen();
+        showEndScreen();
+        return EndState;
+
+    default:
+        cout << "Ivalid Choice !\n ";
+    }
+    return MainMenuState;
+}
+
+// Runs the current state and moves to the next one
+inline void stepSession(sSession &session, sClientStore &store)
+{
+    switch (session.state)
+    {
+    case MainMenuState:
+        syncOperationLogIfIdle(store.operationLog, STDIN_FILENO);
+        session.choice = showMainScreenAndGetUserOption();
+        session.state = OptionState;
+        break;
+
+    case OptionState:
+        refreshClientStore(fileName, delim, store); // another process may have written since the last screen
+        session.state = handleProgram(session.choice, store);
+        break;
+
+    case PauseState:
+        syncOperationLogIfIdle(store.operationLog, STDIN_FILENO);
+        goBackToMainMenu();
+        session.state = MainMenuState;
+        break;
+
+    case EndState:
+        return;
+    }
+    session.transitions++;
+}
+
+inline void runSession(sClientStore &store)
+{
+    sSession session;
+    while (session.state != EndState)
+        stepSession(session, store);
+}
+
+#endif
@@ -0,0 +1,134 @@
+#include "bank_session.h"
+
+using namespace std;
+/*
+=======================================
+Bank Session Soak Test
+=======================================
+
+Drives the interactive session (bank_session.h) with scripted keystrokes and discards the screens:
+find, update and delete declined, the transactions menu and back, an invalid choice and a find that misses,
+round after round on the clients of Clients.txt. Nothing is written to the clients file.
+
+It checks that the menus neither recurse nor leak:
+- Stack: every line of input is handed out from the deepest point of a screen, so the input records the
+  lowest stack address the screens reached. After the first 10% of the transitions it may not drop by more
+  than maxStackGrowthBytes; a session that called the next screen instead of returning to its loop would.
+- Memory: the peak RSS may not grow by more than maxRssGrowthKb between 10% and the end.
+
+Prints transitions/sec, the stack span of the screens and the peak RSS, then PASSED (exit 0) or FAILED (exit 1).
+
+Usage: bank_soak_test [TRANSITIONS=10000000]   (in the directory of Clients.txt)
+Build: g++ -std=c++17 -O2 -pthread bank_soak_test.cpp -o bank_soak_test
+*/
+
+const uintptr_t maxStackGrowthBytes = 4 * 1024;
+const long maxRssGrowthKb = 1024;
+
+// Endless keyboard input, one line per read: one scripted round after another. Records the stack span of the
+// reads, which happen inside the screens.
+struct sScriptedInput : streambuf
+{
+    function<string(size_t)> makeRound;
+    size_t round = 0;
+    string current;
+    size_t next = 0; // start of the next line in 'current'
+    uintptr_t lowestStack = UINTPTR_MAX;
+    uintptr_t highestStack = 0;
+
+    int underflow() override
+    {
+        int marker;
+        uintptr_t address = reinterpret_cast<uintptr_t>(&marker);
+        lowestStack = min(lowestStack, address);
+        highestStack = max(highestStack, address);
+
+        if (next == current.size())
+        {
+            current = makeRound(round++);
+            next = 0;
+        }
+        size_t end = current.find('\n', next) + 1;
+        setg(current.data() + next, current.data() + next, current.data() + end);
+        next = end;
+        return traits_type::to_int_type(*gptr());
+    }
+};
+
+// Swallows everything written to it
+struct sDiscardedOutput : streambuf
+{
+    int overflow(int c) override
+    {
+        return c;
+    }
+    streamsize xsputn(const char *, streamsize n) override
+    {
+        return n;
+    }
+};
+
+int main(int argc, char *argv[])
+{
+    size_t transitions = argc > 1 ? stoull(argv[1]) : 10000000;
+
+    sClientStore store;
+    ensureClientStoreLoaded(fileName, delim, store);
+    if (store.columns.slotOfRow.empty())
+    {
+        cerr << "The soak test needs at least 1 client in '" << fileName << "'.\n";
+        return 1;
+    }
+
+    sScriptedInput input;
+    input.makeRound = [&](size_t round)
+    {
+        string account(slotAccountNumber(store.clients, store.columns.slotOfRow[round % store.columns.slotOfRow.size()]));
+        return "5\n" + account + "\n\n" +          // find
+               "4\n" + account + "\nn\n\n" +      // update, declined
+               "3\n" + account + "\nn\n\n" +      // delete, declined
+               "6\n4\n" +                           // transactions menu and back
+               "42\n5\nNO-SUCH-ACCOUNT\n\n";       // invalid choice, then a find that misses
+    };
+    sDiscardedOutput discarded;
+
+    clearScreenEnabled = false;
+    streambuf *savedInput = cin.rdbuf(&input);
+    streambuf *savedOutput = cout.rdbuf(&discarded);
+
+    sSession session;
+    size_t warmUp = max<size_t>(1, transitions / 10);
+    uintptr_t stackAfterWarmUp = UINTPTR_MAX;
+    long rssAfterWarmUp = 0;
+    auto start = chrono::steady_clock::now();
+    while (session.transitions < transitions && session.state != EndState)
+    {
+        stepSession(session, store);
+        if (session.transitions == warmUp)
+        {
+            stackAfterWarmUp = input.lowestStack; // later growth means the screens recurse
+            rssAfterWarmUp = peakRssKb();          // later growth means a leak
+        }
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    cin.rdbuf(savedInput);
+    cout.rdbuf(savedOutput);
+
+    uintptr_t stackGrowth = (input.lowestStack < stackAfterWarmUp) ? stackAfterWarmUp - input.lowestStack : 0;
+    long rssGrowth = peakRssKb() - rssAfterWarmUp;
+    bool stackOk = session.state != EndState && stackGrowth <= maxStackGrowthBytes;
+    bool rssOk = rssGrowth <= maxRssGrowthKb;
+
+    cout << "Session soak test: " << session.transitions << " menu transitions in " << fixed << setprecision(2) << seconds
+         << " s (" << setprecision(0) << session.transitions / seconds << " transitions/sec)\n";
+    cout << "- stack span     : " << input.highestStack - input.lowestStack << " byte(s) across the screens, grew by "
+         << stackGrowth << " after 10% (limit " << maxStackGrowthBytes << ")\n";
+    cout << "- peak RSS       : " << rssAfterWarmUp << " KB after 10%, " << peakRssKb() << " KB at the end (limit +"
+         << maxRssGrowthKb << " KB)\n";
+    if (session.state == EndState)
+        cout << "- the session ended before all transitions ran\n";
+    cout << (stackOk && rssOk ? "PASSED\n" : "FAILED\n");
+
+    return (stackOk && rssOk) ? 0 : 1;
+}
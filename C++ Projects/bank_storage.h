@@ -0,0 +1,3146 @@
+#ifndef BANK_STORAGE_H
+#define BANK_STORAGE_H
+
+/*
+=======================================
+Bank storage engine — how the client store reaches the disk and comes back
+=======================================
+
+- Loader: Clients.txt is memory-mapped and parsed with string_views straight over the mapping; large files are
+  cut into newline-aligned ranges parsed on worker threads.
+- Crash-safe rewrites: Clients.txt is only ever replaced through a fsynced temp file and a rename, written by a
+  background flusher that coalesces pending rewrites.
+- Operation log (Clients.log): adds, updates, deletes and money changes are appended as records and replayed
+  on load. A delete is a tombstone; a background compactor folds the log back into Clients.txt once the log or
+  the share of deleted rows passes its threshold, with paced I/O.
+- Binary storage (Clients.bin): fixed-width records, so a balance change or a delete is one small pwrite.
+- Index file (Clients.idx): an on-disk B+tree from account number to the client's line in Clients.txt or
+  Clients.log, so a lookup before anything is loaded reads a few pages and one record.
+- Checkpoints (Clients.ckpt): a binary snapshot in which only the changed pages are rewritten; startup maps
+  it and replays only the log written after it.
+- Sharded storage: clients spread over N shard files by account number hash, loaded in parallel, and only
+  the shards whose clients changed are rewritten.
+- Store watcher: a loaded store follows what other processes write to the same files.
+- Client operations: save / update / delete a client in the store and on disk, whatever the storage format.
+*/
+
+#include "bank_indexes.h"
+
+// Defined further down; the log, the flusher and the client lookups need them first
+inline void loadClientStore(string fileName, string delim, sClientStore &store);
+inline bool splitTransferPayload(string_view payload, string_view delim, string_view &first, string_view &second);
+inline bool rebuildClientIndexFile(string fileName, string delim, sIndexFile &index);
+
+// ------------------------------------------------------ CLIENTS FILE ------------------------------------------------------
+// *****************************************************************************************************************
+
+// Appends a list of client records to a text file in a delimited format.
+// If the file doesn't exist, it will be created automatically.
+inline void addClientsToFile(string fileName, string delim, vector<sClient> &vClients)
+{
+
+    // Open file for output in append mode to avoid overwriting existing records
+    ofstream myFile(fileName, ios::out | ios::app);
+
+    if (!myFile.is_open())
+    {
+        cerr << "Error: Could not open file '" << fileName << "' for writing.\n";
+        return;
+    }
+
+    // Write each client's data to the file, one line per client
+    for (const sClient &client : vClients)
+    {
+        // Each line is a delimited string created from the client's fields
+        if (client.markedForDelete == false)
+            myFile << formatClientAsLine(client, delim) << endl;
+    }
+
+    myFile.close();
+}
+
+inline void readClientsFromFile(string fileName, string delim, vector<sClient> &vClients)
+{
+    vClients.clear();
+    ifstream myFile(fileName);
+
+    string line;
+
+    if (myFile.is_open())
+    {
+
+        while (getline(myFile, line))
+        {
+            vector<string> vClientString;
+            splitString(line, vClientString, delim);
+            sClient client;
+            if (!parseClientRecord(vClientString, client))
+            {
+                cerr << "Warning: skipping invalid client record: " << line << "\n";
+                continue;
+            }
+            vClients.push_back(client);
+        }
+    }
+
+    else
+    {
+        cerr << "Error: Could not open file '" << fileName << "' for reading.\n";
+        return;
+    }
+}
+
+// "Clients.txt" + ".bin" -> "Clients.bin"
+inline string replaceFileExtension(const string &fileName, const string &extension)
+{
+    size_t dot = fileName.find_last_of('.');
+    size_t slash = fileName.find_last_of('/');
+    if (dot == string::npos || (slash != string::npos && dot < slash))
+        return fileName + extension;
+    return fileName.substr(0, dot) + extension;
+}
+// ------------------------------------------------------ MEMORY-MAPPED LOADER ------------------------------------------------------
+// *****************************************************************************************************************
+
+// A read-only memory mapping of a whole file
+struct sMappedFile
+{
+    const char *data = nullptr;
+    size_t size = 0;
+};
+
+// Maps the file into memory; an empty file is a valid (empty) mapping
+inline bool mapFile(const string &fileName, sMappedFile &mapped)
+{
+    int fd = open(fileName.c_str(), O_RDONLY);
+    if (fd == -1)
+        return false;
+
+    struct stat info;
+    if (fstat(fd, &info) == -1)
+    {
+        close(fd);
+        return false;
+    }
+
+    mapped.size = info.st_size;
+    mapped.data = nullptr;
+    if (mapped.size > 0)
+    {
+        void *address = mmap(nullptr, mapped.size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address == MAP_FAILED)
+        {
+            close(fd);
+            return false;
+        }
+        madvise(address, mapped.size, MADV_SEQUENTIAL);
+        mapped.data = static_cast<const char *>(address);
+    }
+
+    close(fd); // the mapping stays valid after the descriptor is closed
+    return true;
+}
+
+inline void unmapFile(sMappedFile &mapped)
+{
+    if (mapped.data != nullptr)
+        munmap(const_cast<char *>(mapped.data), mapped.size);
+    mapped.data = nullptr;
+    mapped.size = 0;
+}
+
+// Splits one record line into its 5 fields without copying; returns false if the line is malformed
+inline bool splitClientLine(string_view line, string_view delim, string_view fields[5])
+{
+    short n = 0;
+    size_t pos;
+    while (n < 4 && (pos = simdFind(line, delim)) != string_view::npos)
+    {
+        fields[n++] = line.substr(0, pos);
+        line.remove_prefix(pos + delim.size());
+    }
+    if (n != 4)
+        return false;
+
+    fields[4] = line;
+    return true;
+}
+
+// Parses one record line straight from the mapping into 'client'
+inline bool parseClientLine(string_view line, string_view delim, sClient &client)
+{
+    string_view fields[5];
+    if (!splitClientLine(line, delim, fields))
+        return false;
+
+    sMoney balance;
+    if (!parseMoney(fields[4], balance) || !fitsInCompactRecord(fields[0], fields[2]))
+        return false;
+
+    client.accountNumber.assign(fields[0]);
+    client.pinCode.assign(fields[1]);
+    client.fullName.assign(fields[2]);
+    client.phone.assign(fields[3]);
+    client.accountBalance = balance;
+    client.markedForDelete = false;
+    return true;
+}
+
+// Parses a client line and checks every field with the same rules as the interactive prompts
+inline bool parseValidClientLine(string_view line, string_view delim, sClient &client, string &error)
+{
+    string_view fields[5];
+    if (!splitClientLine(line, delim, fields))
+    {
+        error = "A client line needs 5 fields: account#pin#name#phone#balance.";
+        return false;
+    }
+
+    client.accountNumber = string(fields[0]);
+    client.pinCode = string(fields[1]);
+    client.fullName = string(fields[2]);
+    client.phone = string(fields[3]);
+    string balance(fields[4]);
+
+    // first failing rule wins, the remaining fields are not checked
+    error = accountNumberFormatError(client.accountNumber);
+    if (error.empty())
+        error = pinCodeError(client.pinCode);
+    if (error.empty())
+        error = fullNameError(client.fullName);
+    if (error.empty())
+        error = phoneNumberError(client.phone);
+    if (error.empty())
+        error = accountBalanceError(balance);
+    if (!error.empty())
+        return false;
+
+    parseMoney(balance, client.accountBalance);
+    client.markedForDelete = false;
+    return true;
+}
+
+// Parses one record line straight from the mapping into a new slot
+inline bool appendClientLine(string_view line, string_view delim, sClientSlots &slots)
+{
+    string_view fields[5];
+    sMoney balance;
+    if (!splitClientLine(line, delim, fields) || !parseMoney(fields[4], balance))
+        return false;
+    return appendClientSlot(slots, fields[0], fields[1], fields[2], fields[3], balance);
+}
+
+// Parses every line in [begin, end) and appends the clients to 'slots' (no sClient is built on the way)
+inline void parseClientLines(const char *begin, const char *end, string_view delim, sClientSlots &slots)
+{
+    const char *lineStart = begin;
+    while (lineStart < end)
+    {
+        const char *lineEnd = static_cast<const char *>(memchr(lineStart, '\n', end - lineStart));
+        if (lineEnd == nullptr)
+            lineEnd = end;
+
+        string_view line(lineStart, lineEnd - lineStart);
+        if (!line.empty() && line.back() == '\r')
+            line.remove_suffix(1);
+
+        if (!line.empty() && !appendClientLine(line, delim, slots))
+            cerr << "Warning: skipping invalid client record: " << line << "\n";
+        lineStart = lineEnd + 1;
+    }
+}
+
+// Cuts [data, data + size) into at most 'parts' ranges that each start at the beginning of a line.
+// Returns the range boundaries: range i is [bounds[i], bounds[i + 1]).
+inline vector<size_t> splitAtLineBoundaries(const char *data, size_t size, int parts)
+{
+    vector<size_t> bounds = {0};
+    for (int i = 1; i < parts; i++)
+    {
+        size_t target = max(bounds.back(), size * i / parts);
+        const char *newline = static_cast<const char *>(memchr(data + target, '\n', size - target));
+        if (newline == nullptr)
+            break;
+
+        size_t boundary = newline - data + 1;
+        if (boundary > bounds.back() && boundary < size)
+            bounds.push_back(boundary);
+    }
+    bounds.push_back(size);
+    return bounds;
+}
+
+// Parses the ranges on separate threads into thread-local slots (each with its own arena), then appends them
+// to 'slots' in file order; the arenas' blocks are handed over, not copied
+inline void parseClientLinesInParallel(const char *data, size_t size, string_view delim, sClientSlots &slots, int threads)
+{
+    vector<size_t> bounds = splitAtLineBoundaries(data, size, threads);
+    size_t ranges = bounds.size() - 1;
+
+    vector<sClientSlots> vParts(ranges);
+    vector<thread> workers;
+    for (size_t i = 0; i < ranges; i++)
+    {
+        workers.emplace_back([&, i]()
+                             {
+                                 reserveClientSlots(vParts[i], (bounds[i + 1] - bounds[i]) / 48);
+                                 parseClientLines(data + bounds[i], data + bounds[i + 1], delim, vParts[i]); });
+    }
+    for (thread &worker : workers)
+        worker.join();
+
+    size_t total = 0;
+    for (const sClientSlots &part : vParts)
+        total += slotCount(part);
+
+    reserveClientSlots(slots, total);
+    for (sClientSlots &part : vParts)
+        appendClientSlots(slots, part); // frees each part as soon as it is merged
+}
+
+// Files smaller than this are parsed on the calling thread (starting workers would cost more than it saves)
+const size_t parallelLoadMinBytes = 4 * 1024 * 1024;
+
+// Same result as readClientsFromFile, but parses the memory-mapped file in place,
+// on 'threads' worker threads when the file is large enough
+inline void readClientsFromMappedFile(string fileName, string delim, sClientSlots &slots, int threads = 1)
+{
+    slots = sClientSlots();
+
+    sMappedFile mapped;
+    if (!mapFile(fileName, mapped))
+    {
+        cerr << "Error: Could not open file '" << fileName << "' for reading.\n";
+        return;
+    }
+
+    if (threads > 1 && mapped.size >= parallelLoadMinBytes)
+        parseClientLinesInParallel(mapped.data, mapped.size, delim, slots, threads);
+    else
+    {
+        // A record is rarely shorter than ~48 bytes, so this avoids most reallocations
+        reserveClientSlots(slots, mapped.size / 48);
+        parseClientLines(mapped.data, mapped.data + mapped.size, delim, slots);
+        shrinkClientSlots(slots); // most records are longer, so the estimate leaves spare room
+    }
+    unmapFile(mapped);
+}
+
+// *****************************************************************************************************************
+
+// ------------------------------------------------------ ATOMIC FILE REWRITES ------------------------------------------------------
+// *****************************************************************************************************************
+// A full rewrite never truncates the file in place: the new contents go to "<file>.tmp", which is fsynced and
+// renamed over the file before the directory is fsynced, so after a crash the file is either the old version or
+// the new one. Rewrites of Clients.txt (or of shard files) run on a background flusher thread: the caller only
+// hands over the contents (or asks for a merge with the retired log), and a rewrite asked for while an older
+// one of the same file is still waiting replaces it, so only the newest one is written.
+
+// "Clients.txt" -> "Clients.txt.tmp"
+inline string temporaryFileNameFor(const string &fileName)
+{
+    return fileName + ".tmp";
+}
+
+// Forces a file's contents to disk
+inline bool fsyncFile(const string &fileName)
+{
+    int fd = open(fileName.c_str(), O_RDONLY);
+    if (fd == -1)
+        return false;
+    bool ok = (fsync(fd) == 0);
+    close(fd);
+    return ok;
+}
+
+// Forces the directory entry changes (create, rename, unlink) around 'fileName' to disk
+inline void fsyncParentDirectory(const string &fileName)
+{
+    size_t slash = fileName.find_last_of('/');
+    string directory = (slash == string::npos) ? "." : fileName.substr(0, max<size_t>(slash, 1));
+    int fd = open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd == -1)
+        return;
+    fsync(fd);
+    close(fd);
+}
+
+// Makes the finished "<file>.tmp" durable and renames it over 'fileName'
+inline bool replaceWithTemporaryFile(const string &fileName)
+{
+    string temporaryFileName = temporaryFileNameFor(fileName);
+    if (!fsyncFile(temporaryFileName) || rename(temporaryFileName.c_str(), fileName.c_str()) != 0)
+    {
+        cerr << "Error: Could not replace file '" << fileName << "'.\n";
+        unlink(temporaryFileName.c_str());
+        return false;
+    }
+    fsyncParentDirectory(fileName);
+    return true;
+}
+
+// Spreads background I/O over time so it leaves the disk to the foreground: after each chunk, sleeps until
+// the bytes read and written so far fit the budget
+struct sIoPacer
+{
+    size_t bytesPerSecond = 0; // 0 = unlimited
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    uint64_t bytes = 0;
+};
+
+const size_t pacedChunkBytes = 1024 * 1024;
+
+inline void paceIo(sIoPacer &pacer, size_t bytes)
+{
+    pacer.bytes += bytes;
+    if (pacer.bytesPerSecond == 0)
+        return;
+    chrono::duration<double> due(static_cast<double>(pacer.bytes) / pacer.bytesPerSecond);
+    this_thread::sleep_until(pacer.start + chrono::duration_cast<chrono::steady_clock::duration>(due));
+}
+
+// Replaces the whole file with 'contents' (temp + fsync + rename). With a pacer the contents are written
+// in chunks, each one pushed towards the disk before the pause, so the final fsync has little left to do.
+// Appends 'data' to fd, whose first 'offset' bytes are already written; paced writes go out in
+// pacedChunkBytes pieces and are pushed to the disk as they go
+inline bool writeFileChunk(int fd, string_view data, uint64_t &offset, sIoPacer *pacer)
+{
+    size_t written = 0;
+    while (written < data.size())
+    {
+        size_t chunk = data.size() - written;
+        if (pacer != nullptr)
+            chunk = min(chunk, pacedChunkBytes);
+        ssize_t n = write(fd, data.data() + written, chunk);
+        if (n <= 0)
+            return false;
+        if (pacer != nullptr)
+        {
+            startWriteback(fd, offset, n);
+            paceIo(*pacer, n);
+        }
+        written += n;
+        offset += n;
+    }
+    return true;
+}
+
+inline bool writeFileAtomically(const string &fileName, const string &contents, sIoPacer *pacer = nullptr)
+{
+    string temporaryFileName = temporaryFileNameFor(fileName);
+    int fd = open(temporaryFileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1)
+    {
+        cerr << "Error: Could not open file '" << temporaryFileName << "' for writing.\n";
+        return false;
+    }
+
+    uint64_t offset = 0;
+    bool written = writeFileChunk(fd, contents, offset, pacer);
+    close(fd);
+
+    if (!written)
+    {
+        cerr << "Error: Could not write to file '" << temporaryFileName << "'.\n";
+        unlink(temporaryFileName.c_str());
+        return false;
+    }
+    return replaceWithTemporaryFile(fileName);
+}
+
+// The live clients as the text of a clients file
+inline string formatClientsFileContents(const sClientSlots &slots, const string &delim)
+{
+    string contents;
+    for (size_t slot = 0; slot < slotCount(slots); slot++)
+    {
+        if (isSlotDeleted(slots, slot))
+            continue;
+        appendSlotAsLine(contents, slots, slot, delim);
+        contents += '\n';
+    }
+    return contents;
+}
+
+// "Clients.txt" -> "Clients.log.compacting": log records whose compaction has not reached Clients.txt yet
+inline string retiredLogNameFor(const string &fileName)
+{
+    return replaceFileExtension(fileName, ".log.compacting");
+}
+
+// The index rebuild a compaction asked for can start once its retired log is released; the caller holds flusher.lock
+inline bool isIndexRebuildDue(const sClientsFileFlusher &flusher)
+{
+    return !flusher.indexRebuildFileName.empty() && flusher.retiredLogName.empty();
+}
+
+inline void getFileVersion(const string &fileName, uint64_t &bytes, int64_t &modified);
+
+// Once every rewrite is on disk, the retired log they cover is no longer needed; the caller holds flusher.lock
+inline void releaseRetiredLogIfWritten(sClientsFileFlusher &flusher)
+{
+    if (flusher.retiredLogName.empty() || !flusher.pendingFiles.empty() || !flusher.failedFiles.empty() || flusher.busy)
+        return;
+    unlink(flusher.retiredLogName.c_str());
+    flusher.retiredLogName.clear();
+}
+
+inline bool mergeRetiredLogIntoFile(const string &fileName, const sFileRewrite &rewrite, const string &retiredLogName, uint64_t retiredLogBytes,
+                             sIoPacer &pacer, size_t &tombstonesPurged, uint64_t &bytesReclaimed);
+
+// Rebuilds Clients.idx on the flusher thread (guard holds flusher.lock); lookups leave the index alone meanwhile,
+// since the flusher is busy
+inline void rebuildIndexFileOnFlusher(sClientsFileFlusher &flusher, unique_lock<mutex> &guard)
+{
+    string fileName = move(flusher.indexRebuildFileName);
+    flusher.indexRebuildFileName.clear();
+    flusher.busy = true;
+    guard.unlock();
+    {
+        sIndexFile index;
+        rebuildClientIndexFile(fileName, flusher.indexRebuildDelim, index);
+    } // closed here, once its pages are on disk
+    guard.lock();
+    flusher.busy = false;
+    flusher.changed.notify_all();
+}
+
+// Writes the pending rewrites until asked to stop
+inline void runClientsFileFlusher(sClientsFileFlusher &flusher)
+{
+    unique_lock<mutex> guard(flusher.lock);
+    while (true)
+    {
+        flusher.changed.wait(guard, [&]()
+                             { return !flusher.pendingFiles.empty() || isIndexRebuildDue(flusher) || flusher.stopping; });
+        if (flusher.pendingFiles.empty())
+        {
+            if (!isIndexRebuildDue(flusher))
+                return;
+            rebuildIndexFileOnFlusher(flusher, guard);
+            continue;
+        }
+
+        auto next = flusher.pendingFiles.begin();
+        string fileName = next->first;
+        sFileRewrite rewrite = move(next->second);
+        flusher.pendingFiles.erase(next);
+        flusher.busy = true;
+
+        // measured while holding the lock: a compaction appends to the retired log under it (and queues this
+        // file again, so the records past this point are merged by the next rewrite)
+        string retiredLogName = flusher.retiredLogName;
+        uint64_t retiredLogBytes = 0;
+        int64_t retiredLogModified;
+        if (rewrite.mergeRetiredLog)
+            getFileVersion(retiredLogName, retiredLogBytes, retiredLogModified);
+
+        guard.unlock();
+        auto start = chrono::steady_clock::now();
+        size_t tombstonesPurged = 0;
+        uint64_t bytesReclaimed = 0;
+        bool written;
+        if (rewrite.mergeRetiredLog)
+        {
+            sIoPacer pacer;
+            pacer.bytesPerSecond = flusher.bytesPerSecond;
+            written = mergeRetiredLogIntoFile(fileName, rewrite, retiredLogName, retiredLogBytes, pacer, tombstonesPurged, bytesReclaimed);
+        }
+        else
+            written = writeFileAtomically(fileName, rewrite.contents);
+        chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+        guard.lock();
+
+        flusher.busy = false;
+        if (written)
+            flusher.written++;
+        else if (flusher.pendingFiles.count(fileName) == 0)
+            flusher.failedFiles[fileName] = move(rewrite);
+        if (written && rewrite.mergeRetiredLog)
+        {
+            flusher.compactions++;
+            flusher.tombstonesPurged += tombstonesPurged;
+            flusher.bytesReclaimed += bytesReclaimed;
+            flusher.lastCompactionSeconds = elapsed.count();
+        }
+        releaseRetiredLogIfWritten(flusher);
+        flusher.changed.notify_all();
+    }
+}
+
+// Asks the flusher to rebuild Clients.idx once the current compaction is on disk; the caller holds flusher.lock
+inline void requestIndexFileRebuild(sClientsFileFlusher &flusher, const string &fileName, const string &delim)
+{
+    if (!flusher.worker.joinable())
+        flusher.worker = thread(runClientsFileFlusher, ref(flusher));
+    flusher.indexRebuildFileName = fileName;
+    flusher.indexRebuildDelim = delim;
+    flusher.changed.notify_all();
+}
+
+// Queues a rewrite of 'fileName' (and retries the rewrites that failed); the caller holds flusher.lock
+inline void queueClientsFileRewrite(sClientsFileFlusher &flusher, const string &fileName, sFileRewrite rewrite)
+{
+    if (!flusher.worker.joinable())
+        flusher.worker = thread(runClientsFileFlusher, ref(flusher));
+    if (flusher.pendingFiles.count(fileName) != 0)
+        flusher.coalesced++;
+
+    flusher.failedFiles.erase(fileName);
+    for (auto &failed : flusher.failedFiles)
+        flusher.pendingFiles.emplace(failed.first, move(failed.second));
+    flusher.failedFiles.clear();
+
+    flusher.pendingFiles[fileName] = move(rewrite);
+    flusher.requested++;
+    flusher.changed.notify_all();
+}
+
+inline void requestClientsFileRewrite(sClientsFileFlusher &flusher, const string &fileName, string contents)
+{
+    sFileRewrite rewrite;
+    rewrite.contents = move(contents);
+    lock_guard<mutex> guard(flusher.lock);
+    queueClientsFileRewrite(flusher, fileName, move(rewrite));
+}
+
+// Blocks until every requested rewrite is on disk
+inline void waitForClientsFileRewrites(sClientsFileFlusher &flusher)
+{
+    unique_lock<mutex> guard(flusher.lock);
+    flusher.changed.wait(guard, [&]()
+                         { return flusher.pendingFiles.empty() && !flusher.busy && !isIndexRebuildDue(flusher); });
+}
+
+// Writes what is still pending and ends the thread
+inline void stopClientsFileFlusher(sClientsFileFlusher &flusher)
+{
+    {
+        lock_guard<mutex> guard(flusher.lock);
+        flusher.stopping = true;
+        flusher.changed.notify_all();
+    }
+    if (flusher.worker.joinable())
+        flusher.worker.join();
+}
+
+inline sClientsFileFlusher::~sClientsFileFlusher()
+{
+    stopClientsFileFlusher(*this);
+}
+
+// *****************************************************************************************************************
+
+// ------------------------------------------------------ OPERATION LOG ------------------------------------------------------
+// *****************************************************************************************************************
+// Every change is appended to "<clients file>.log" as one line: ADD / UPDATE followed by the client line,
+// DELETE followed by the account number, or TRANSFER followed by the two updated client lines. Clients.txt is only rewritten by compaction.
+
+const string logAdd = "ADD";
+const string logUpdate = "UPDATE";
+const string logDelete = "DELETE";
+const string logTransfer = "TRANSFER"; // both client lines of a transfer in one record, so it replays atomically
+
+// "Clients.txt" -> "Clients.log"
+inline string operationLogNameFor(const string &fileName)
+{
+    return replaceFileExtension(fileName, ".log");
+}
+
+inline bool openOperationLog(sOperationLog &log, const string &clientsFileName)
+{
+    string logFileName = operationLogNameFor(clientsFileName);
+    if (log.fd != -1 && log.fileName == logFileName)
+        return true;
+    if (log.fd != -1)
+        close(log.fd);
+
+    log.fileName = logFileName;
+    log.fd = open(logFileName.c_str(), O_WRONLY | O_APPEND | O_CREAT, 0644);
+    if (log.fd == -1)
+    {
+        cerr << "Error: Could not open file '" << logFileName << "' for writing.\n";
+        return false;
+    }
+    log.bytes = lseek(log.fd, 0, SEEK_END);
+    log.pendingOps = 0;
+    return true;
+}
+
+// fsyncs the operations written since the last sync
+inline void syncOperationLog(sOperationLog &log)
+{
+    if (log.fd == -1 || log.pendingOps == 0)
+        return;
+    syncFileData(log.fd);
+    log.pendingOps = 0;
+}
+
+// Group commit when the program goes idle: the window is only checked by the next append, which may not come
+// for a long time, so pending operations are synced as soon as no input is waiting on 'inputFd'
+inline void syncOperationLogIfIdle(sOperationLog &log, int inputFd)
+{
+    if (log.pendingOps == 0)
+        return;
+    pollfd input = {inputFd, POLLIN, 0};
+    if (poll(&input, 1, 0) == 0)
+        syncOperationLog(log);
+}
+
+// Writes one record to the log and applies the fsync policy
+inline bool appendToOperationLog(sOperationLog &log, const string &clientsFileName, const string &record)
+{
+    if (!openOperationLog(log, clientsFileName))
+        return false;
+
+    string line = record + "\n";
+    size_t written = 0;
+    while (written < line.size())
+    {
+        ssize_t n = write(log.fd, line.data() + written, line.size() - written);
+        if (n <= 0)
+        {
+            cerr << "Error: Could not write to file '" << log.fileName << "'.\n";
+            return false;
+        }
+        written += n;
+    }
+    log.bytes += line.size();
+
+    if (log.pendingOps == 0)
+        log.oldestPending = chrono::steady_clock::now();
+    log.pendingOps++;
+
+    if (log.fsyncPolicy == FsyncEveryOp)
+        syncOperationLog(log);
+    else if (log.fsyncPolicy == FsyncGroupCommit)
+    {
+        auto pendingFor = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - log.oldestPending);
+        if (log.pendingOps >= log.groupCommitSize || pendingFor.count() >= log.groupCommitWindowMs)
+            syncOperationLog(log);
+    }
+    return true;
+}
+
+// Applies one log line to the store; returns false if the line is not a valid record
+inline bool applyOperationLogRecord(const string &line, string delim, sClientStore &store)
+{
+    size_t pos = simdFind(line, delim);
+    if (pos == string::npos)
+        return false;
+
+    string operation = line.substr(0, pos);
+    string payload = line.substr(pos + delim.length());
+
+    if (operation == logDelete)
+    {
+        markClientAsDeletedInStore(store, payload);
+        return true;
+    }
+
+    vector<string_view> vClientLines;
+    if (operation == logAdd || operation == logUpdate)
+        vClientLines.push_back(payload);
+    else if (operation == logTransfer)
+    {
+        string_view first, second;
+        if (!splitTransferPayload(payload, delim, first, second))
+            return false;
+        vClientLines.push_back(first);
+        vClientLines.push_back(second);
+    }
+    else
+        return false;
+
+    vector<sClient> vChangedClients(vClientLines.size());
+    for (size_t i = 0; i < vClientLines.size(); i++)
+    {
+        if (!parseClientLine(vClientLines[i], delim, vChangedClients[i]))
+            return false;
+    }
+
+    // replaying must be idempotent: an ADD of a known account or an UPDATE of an unknown one both upsert
+    for (const sClient &client : vChangedClients)
+    {
+        if (!updateClientInStore(store, client))
+            addClientToStore(store, client);
+    }
+    return true;
+}
+
+// Replays one log file (from byte 'start' on) on top of the store and returns the offset after the last
+// complete record. A torn last line (crash in the middle of a write) has no newline and is ignored.
+inline uint64_t replayOperationLogFile(const string &logFileName, string delim, sClientStore &store, uint64_t start = 0)
+{
+    ifstream logFile(logFileName);
+    if (!logFile.is_open())
+        return start;
+    logFile.seekg(start);
+
+    uint64_t end = start;
+    string line;
+    while (getline(logFile, line))
+    {
+        if (logFile.eof())
+            break; // incomplete record
+        end += line.size() + 1;
+
+        if (!applyOperationLogRecord(line, delim, store))
+            cerr << "Warning: skipping invalid log record: " << line << "\n";
+    }
+    return end;
+}
+
+// Replays the log on top of the clients loaded from the base file, starting with the records of a
+// compaction that may not have reached the base file (replaying them over one that has is harmless).
+// Returns how far Clients.log was replayed.
+inline uint64_t replayOperationLog(string fileName, string delim, sClientStore &store)
+{
+    replayOperationLogFile(retiredLogNameFor(fileName), delim, store);
+    return replayOperationLogFile(operationLogNameFor(fileName), delim, store);
+}
+
+// Moves the log's records to the retired log and starts an empty log; the caller holds the flusher lock.
+// The first compaction renames the log, later ones (while a rewrite is still outstanding) append to it.
+inline bool retireOperationLog(string fileName, sClientStore &store)
+{
+    sOperationLog &log = store.operationLog;
+    string retiredLogName = retiredLogNameFor(fileName);
+    if (!openOperationLog(log, fileName))
+        return false;
+
+    if (access(retiredLogName.c_str(), F_OK) != 0)
+    {
+        close(log.fd);
+        log.fd = -1;
+        if (rename(log.fileName.c_str(), retiredLogName.c_str()) != 0)
+            return false;
+        fsyncParentDirectory(retiredLogName);
+    }
+    else
+    {
+        ifstream logFile(log.fileName, ios::binary);
+        ofstream retiredLog(retiredLogName, ios::binary | ios::app);
+        retiredLog << logFile.rdbuf();
+        retiredLog.close();
+        if (!retiredLog || !fsyncFile(retiredLogName))
+            return false;
+        // a new file rather than a truncated one, so a checkpoint reaching into the old log cannot match it
+        close(log.fd);
+        log.fd = -1;
+        unlink(log.fileName.c_str());
+        fsyncParentDirectory(log.fileName);
+    }
+
+    log.bytes = 0;
+    log.pendingOps = 0;
+    return openOperationLog(log, fileName);
+}
+
+// Puts the records of a compaction that never finished (the program ended before its rewrite did) back in
+// front of the log; returns true if there were any
+inline bool restoreRetiredOperationLog(string fileName, sClientStore &store)
+{
+    string retiredLogName = retiredLogNameFor(fileName);
+    ifstream retiredLog(retiredLogName, ios::binary);
+    if (!retiredLog.is_open())
+        return false;
+
+    ifstream logFile(operationLogNameFor(fileName), ios::binary);
+    string contents((istreambuf_iterator<char>(retiredLog)), istreambuf_iterator<char>());
+    contents.append(istreambuf_iterator<char>(logFile), istreambuf_iterator<char>());
+
+    sOperationLog &log = store.operationLog;
+    if (log.fd != -1)
+    {
+        close(log.fd);
+        log.fd = -1;
+    }
+    if (!writeFileAtomically(operationLogNameFor(fileName), contents))
+        return false;
+    unlink(retiredLogName.c_str());
+    return true;
+}
+
+inline string shardFileNameFor(const string &fileName, size_t shard, size_t shardCount);
+
+// True once 'tombstoneCount' makes up the compaction ratio of 'rows'
+inline bool isTombstoneRatioPassed(const sTombstones &tombstones, size_t tombstoneCount, size_t rows)
+{
+    return tombstoneCount > 0 && tombstoneCount >= tombstones.compactionRatio * rows;
+}
+
+// Drops the deleted slots from the store. It renumbers every slot and rebuilds the indexes, the one part of
+// a compaction that runs in the foreground, so it waits until the deleted slots pass the tombstone ratio.
+inline void purgeTombstonesFromMemory(sClientStore &store)
+{
+    auto start = chrono::steady_clock::now();
+    compactClientStore(store);
+    store.tombstones.memoryPurges++;
+    store.tombstones.lastMemoryPurgeSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+inline bool catchUpOnStoreFiles(string fileName, string delim, sClientStore &store);
+inline void closeIndexFile(sIndexFile &index);
+
+// Folds the log into the base file: the log's records move to the retired log and an empty log takes its
+// place, which is all the caller waits for. The background compactor then merges the retired log into
+// Clients.txt (or into just the shard files whose clients changed) and deletes it once the rewrites are on
+// disk. Replaying a log over a base file that already contains its changes is harmless, so a crash at any
+// point loses nothing.
+inline void compactOperationLog(string fileName, string delim, sClientStore &store)
+{
+    sOperationLog &log = store.operationLog;
+    syncOperationLog(log);
+
+    sFileRewrite merge;
+    merge.mergeRetiredLog = true;
+    merge.delim = delim;
+    vector<pair<string, sFileRewrite>> rewrites;
+    if (store.storageFormat == ShardedStorage)
+    {
+        merge.shardCount = store.shards.shardCount;
+        for (merge.shard = 0; merge.shard < merge.shardCount; merge.shard++)
+        {
+            if (store.shards.dirtyShards[merge.shard].load(memory_order_relaxed))
+                rewrites.push_back({shardFileNameFor(fileName, merge.shard, merge.shardCount), merge});
+        }
+    }
+    else
+        rewrites.push_back({fileName, merge});
+    bool storeCurrent;
+    {
+        lock_guard<mutex> guard(store.fileFlusher.lock);
+        // records other processes appended leave with the retired log, so the store takes them in first
+        storeCurrent = catchUpOnStoreFiles(fileName, delim, store);
+        if (!retireOperationLog(fileName, store))
+            return; // the records stay in the log and are folded in next time
+        for (auto &rewrite : rewrites)
+            queueClientsFileRewrite(store.fileFlusher, rewrite.first, move(rewrite.second));
+        if (store.storageFormat == ShardedStorage)
+            markAllShardsWritten(store);
+        store.fileFlusher.retiredLogName = retiredLogNameFor(fileName);
+        releaseRetiredLogIfWritten(store.fileFlusher); // nothing to rewrite
+    }
+    store.tombstones.inFiles = 0;
+    if (storeCurrent)
+        store.watcher.rebaseline = true; // both files change, but from the store itself
+    else
+        store.watcher.changed = true; // another process replaced a file: the next refresh reloads the store
+
+    if (isTombstoneRatioPassed(store.tombstones, store.tombstones.inMemory, slotCount(store.clients)))
+        purgeTombstonesFromMemory(store);
+
+    // every line moves, so an open index is closed and the flusher rebuilds it against the new file once that
+    // is in place; the caller does not wait for either
+    if (store.indexFile.fd != -1)
+    {
+        closeIndexFile(store.indexFile);
+        lock_guard<mutex> guard(store.fileFlusher.lock);
+        requestIndexFileRebuild(store.fileFlusher, fileName, delim);
+    }
+}
+
+// Writes several records with a single write() and a single fsync (unless the policy is FsyncNone)
+inline bool appendBatchToOperationLog(sOperationLog &log, const string &clientsFileName, const vector<string> &records)
+{
+    if (records.empty())
+        return true;
+    if (!openOperationLog(log, clientsFileName))
+        return false;
+
+    string buffer;
+    for (const string &record : records)
+    {
+        buffer += record;
+        buffer += '\n';
+    }
+
+    size_t written = 0;
+    while (written < buffer.size())
+    {
+        ssize_t n = write(log.fd, buffer.data() + written, buffer.size() - written);
+        if (n <= 0)
+        {
+            cerr << "Error: Could not write to file '" << log.fileName << "'.\n";
+            return false;
+        }
+        written += n;
+    }
+    log.bytes += buffer.size();
+
+    if (log.pendingOps == 0)
+        log.oldestPending = chrono::steady_clock::now();
+    log.pendingOps += records.size();
+    if (log.fsyncPolicy != FsyncNone)
+        syncOperationLog(log);
+    return true;
+}
+
+inline void writeCheckpointIfDue(string fileName, sClientStore &store);
+
+// Log upkeep after a write by a caller that holds the store exclusively: compaction once the log is large
+// or the deleted rows in the files pass the tombstone ratio, then a checkpoint when due
+inline void compactOperationLogIfNeeded(string fileName, string delim, sClientStore &store)
+{
+    const sTombstones &tombstones = store.tombstones;
+    if (store.operationLog.bytes >= store.operationLog.compactionThreshold ||
+        isTombstoneRatioPassed(tombstones, tombstones.inFiles, store.accountIndex.live + tombstones.inFiles))
+        compactOperationLog(fileName, delim, store);
+    writeCheckpointIfDue(fileName, store);
+}
+
+inline bool logClientAdded(string fileName, string delim, const sClient &client, sClientStore &store)
+{
+    return appendToOperationLog(store.operationLog, fileName, logAdd + delim + formatClientAsLine(client, delim));
+}
+
+inline void logClientUpdated(string fileName, string delim, const sClient &client, sClientStore &store)
+{
+    appendToOperationLog(store.operationLog, fileName, logUpdate + delim + formatClientAsLine(client, delim));
+}
+
+inline void logClientDeleted(string fileName, string delim, const string &accountNumber, sClientStore &store)
+{
+    appendToOperationLog(store.operationLog, fileName, logDelete + delim + accountNumber);
+}
+
+// *****************************************************************************************************************
+
+// ------------------------------------------------------ BACKGROUND COMPACTION ------------------------------------------------------
+// *****************************************************************************************************************
+// A delete marks the slot and appends a DELETE record, its tombstone: the client drops out of the index and of
+// every read at once, while its line stays in Clients.txt until the next compaction. A compaction starts once
+// the log passes --compact-threshold bytes or the tombstones pass --tombstone-ratio of the rows in the files.
+// The foreground only retires the log; the flusher thread, as the background compactor, then streams the base
+// file through the retired records into a new file, paced to --compact-rate MB/s so that the log
+// fsyncs of foreground writes keep the disk. STATS reports the tombstones and what the compactor did.
+
+// The accounts the retired log touches, each in the state its last record left it in (a DELETE alone
+// leaves a row marked for delete). The base file itself is never held in memory.
+struct sMergedRows
+{
+    vector<sClient> rows; // in the order the log first touched them, which is the order new accounts are appended
+    vector<bool> added;   // an ADD / UPDATE / TRANSFER record gave the account a line
+    vector<bool> inFile;  // the account's line was met in the base file
+    unordered_map<string, size_t> rowOf;
+};
+
+// The row of an account, created on first touch
+inline size_t mergedRowOf(sMergedRows &merged, const string &accountNumber)
+{
+    auto [found, inserted] = merged.rowOf.try_emplace(accountNumber, merged.rows.size());
+    if (inserted)
+    {
+        merged.rows.emplace_back();
+        merged.rows.back().accountNumber = accountNumber;
+        merged.added.push_back(false);
+        merged.inFile.push_back(false);
+    }
+    return found->second;
+}
+
+// Applies one retired log record to the rows, skipping the accounts of other shards
+inline void applyRecordToMergedRows(string_view line, const sFileRewrite &rewrite, const sShardedStorage &shards, sMergedRows &merged)
+{
+    auto inShard = [&](const string &accountNumber)
+    {
+        return shards.shardCount == 0 || shardOfAccount(shards, accountNumber) == rewrite.shard;
+    };
+
+    size_t pos = simdFind(line, rewrite.delim);
+    if (pos == string_view::npos)
+        return;
+    string_view operation = line.substr(0, pos);
+    string_view payload = line.substr(pos + rewrite.delim.size());
+
+    if (operation == logDelete)
+    {
+        string accountNumber(payload);
+        if (inShard(accountNumber))
+            merged.rows[mergedRowOf(merged, accountNumber)].markedForDelete = true; // its line may be in the base file
+        return;
+    }
+
+    vector<string_view> vClientLines;
+    if (operation == logAdd || operation == logUpdate)
+        vClientLines.push_back(payload);
+    else if (operation == logTransfer)
+    {
+        string_view first, second;
+        if (!splitTransferPayload(payload, rewrite.delim, first, second))
+            return;
+        vClientLines.push_back(first);
+        vClientLines.push_back(second);
+    }
+
+    for (string_view clientLine : vClientLines)
+    {
+        sClient client;
+        if (parseClientLine(clientLine, rewrite.delim, client) && inShard(client.accountNumber))
+        {
+            size_t row = mergedRowOf(merged, client.accountNumber);
+            merged.rows[row] = client; // a re-added account takes its old line back
+            merged.added[row] = true;
+        }
+    }
+}
+
+// The background compactor's part: merges the retired log records that belong to 'fileName' into it and
+// replaces it, pacing the reads and writes. Only the log's accounts are held in memory: the base file is
+// streamed line by line into the new file (a line the log changed is replaced, a deleted one dropped, any
+// other copied as it is), then the log's new accounts are appended. A file that does not exist yet merges as empty.
+inline bool mergeRetiredLogIntoFile(const string &fileName, const sFileRewrite &rewrite, const string &retiredLogName, uint64_t retiredLogBytes,
+                             sIoPacer &pacer, size_t &tombstonesPurged, uint64_t &bytesReclaimed)
+{
+    // the retired log is mapped and walked record by record, like the base file below; only its first
+    // 'retiredLogBytes' are merged, records appended after that go with the next rewrite
+    sMergedRows merged;
+    sShardedStorage shards;
+    shards.shardCount = rewrite.shardCount;
+    sMappedFile retiredLog;
+    if (retiredLogBytes > 0 && !mapFile(retiredLogName, retiredLog))
+    {
+        cerr << "Error: Could not open file '" << retiredLogName << "' for reading.\n";
+        return false;
+    }
+    string_view records(retiredLog.data, min<uint64_t>(retiredLogBytes, retiredLog.size));
+    size_t lineStart = 0, lineEnd, readSincePace = 0;
+    while ((lineEnd = records.find('\n', lineStart)) != string_view::npos) // a torn last record is left to replay
+    {
+        applyRecordToMergedRows(records.substr(lineStart, lineEnd - lineStart), rewrite, shards, merged);
+        readSincePace += lineEnd + 1 - lineStart;
+        if (readSincePace >= pacedChunkBytes)
+        {
+            paceIo(pacer, readSincePace);
+            readSincePace = 0;
+        }
+        lineStart = lineEnd + 1;
+    }
+    paceIo(pacer, readSincePace);
+    if (retiredLogBytes > 0)
+        unmapFile(retiredLog);
+
+    string temporaryFileName = temporaryFileNameFor(fileName);
+    int fd = open(temporaryFileName.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1)
+    {
+        cerr << "Error: Could not open file '" << temporaryFileName << "' for writing.\n";
+        return false;
+    }
+
+    string buffer;
+    uint64_t offset = 0;
+    bool written = true;
+    auto flushBuffer = [&](size_t atLeast)
+    {
+        if (written && buffer.size() >= atLeast)
+        {
+            written = writeFileChunk(fd, buffer, offset, &pacer);
+            buffer.clear();
+        }
+    };
+
+    sMappedFile mapped;
+    if (mapFile(fileName, mapped))
+    {
+        string_view contents(mapped.data, mapped.size);
+        size_t readSincePace = 0;
+        for (size_t start = 0; start < contents.size() && written;)
+        {
+            size_t end = contents.find('\n', start);
+            end = (end == string_view::npos) ? contents.size() : end + 1;
+            string_view line = contents.substr(start, end - start);
+            size_t delimPos = simdFind(line, rewrite.delim);
+            auto found = merged.rowOf.end();
+            if (delimPos != string_view::npos)
+                found = merged.rowOf.find(string(line.substr(0, delimPos)));
+
+            if (found == merged.rowOf.end())
+            {
+                buffer += line;
+                if (buffer.back() != '\n')
+                    buffer += '\n';
+            }
+            else if (merged.rows[found->second].markedForDelete)
+            {
+                tombstonesPurged++;
+                bytesReclaimed += line.size();
+            }
+            else if (!merged.inFile[found->second]) // a duplicate line of the account is dropped
+            {
+                buffer += formatClientAsLine(merged.rows[found->second], rewrite.delim);
+                buffer += '\n';
+            }
+            if (found != merged.rowOf.end())
+                merged.inFile[found->second] = true;
+
+            readSincePace += line.size();
+            if (readSincePace >= pacedChunkBytes)
+            {
+                paceIo(pacer, readSincePace);
+                readSincePace = 0;
+            }
+            flushBuffer(pacedChunkBytes);
+            start = end;
+        }
+        paceIo(pacer, readSincePace);
+        unmapFile(mapped);
+    }
+
+    for (size_t row = 0; row < merged.rows.size() && written; row++)
+    {
+        if (merged.inFile[row] || !merged.added[row])
+            continue;
+        if (merged.rows[row].markedForDelete)
+            tombstonesPurged++; // added and deleted again before it ever reached the file
+        else
+        {
+            buffer += formatClientAsLine(merged.rows[row], rewrite.delim);
+            buffer += '\n';
+        }
+        flushBuffer(pacedChunkBytes);
+    }
+    flushBuffer(0);
+    close(fd);
+
+    if (!written)
+    {
+        cerr << "Error: Could not write to file '" << temporaryFileName << "'.\n";
+        unlink(temporaryFileName.c_str());
+        return false;
+    }
+    return replaceWithTemporaryFile(fileName);
+}
+
+// STATS: the tombstones waiting for a compaction and what the background compactor did so far
+inline string formatCompactionStats(sClientStore &store, const string &delim)
+{
+    const sTombstones &tombstones = store.tombstones;
+    size_t fileRows = store.accountIndex.live + tombstones.inFiles;
+    double ratio = (fileRows == 0) ? 0 : static_cast<double>(tombstones.inFiles) / fileRows;
+
+    string stats;
+    auto addField = [&](const string &name, const string &value)
+    {
+        stats += (stats.empty() ? "" : delim) + name + "=" + value;
+    };
+    auto decimals = [](double value, int digits)
+    {
+        char text[32];
+        snprintf(text, sizeof(text), "%.*f", digits, value);
+        return string(text);
+    };
+
+    sClientsFileFlusher &flusher = store.fileFlusher;
+    lock_guard<mutex> guard(flusher.lock);
+    addField("tombstones", to_string(tombstones.inFiles));
+    addField("tombstone_ratio", decimals(ratio, 4));
+    addField("memory_tombstones", to_string(tombstones.inMemory));
+    addField("compactions", to_string(flusher.compactions));
+    addField("tombstones_purged", to_string(flusher.tombstonesPurged));
+    addField("bytes_reclaimed", to_string(flusher.bytesReclaimed));
+    addField("last_compaction_ms", decimals(flusher.lastCompactionSeconds * 1000, 1));
+    addField("pending_rewrites", to_string(flusher.pendingFiles.size() + (flusher.busy ? 1 : 0)));
+    addField("memory_purges", to_string(tombstones.memoryPurges));
+    addField("last_memory_purge_ms", decimals(tombstones.lastMemoryPurgeSeconds * 1000, 1));
+    return stats;
+}
+
+// *****************************************************************************************************************
+
+// ------------------------------------------------------ BINARY STORAGE ------------------------------------------------------
+// *****************************************************************************************************************
+// Clients.bin = one header followed by fixed-size records. Record n lives at
+// sizeof(header) + n * sizeof(record) and always holds slot n of the store, so updating a balance or
+// deleting a client is a pwrite of a few bytes instead of a file rewrite. Balances are stored as whole
+// cents; a version 1 file (double balances) is still read, and converted when the store is loaded from it.
+
+const char binaryFileMagic[4] = {'B', 'C', 'L', 'F'};
+const uint32_t binaryFileVersion = 2;
+const uint32_t binaryFileVersionWithDoubles = 1;
+
+const uint8_t binaryRecordLive = 0;
+const uint8_t binaryRecordDeleted = 1;
+
+struct sBinaryFileHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t recordSize;
+    uint32_t reserved;
+    uint64_t recordCount;
+};
+
+// Text fields are padded with '\0' and are not terminated when they use the full capacity
+struct sBinaryClientRecord
+{
+    int64_t accountBalance; // cents (a double in version 1)
+    uint8_t status; // binaryRecordLive or binaryRecordDeleted
+    char pinCode[pinCodeCapacity];
+    char phone[phoneCapacity];
+    char accountNumber[accountNumberCapacity];
+    char fullName[fullNameCapacity];
+    char reserved[4];
+};
+
+static_assert(sizeof(sBinaryFileHeader) == 24, "binary header layout changed");
+static_assert(sizeof(sBinaryClientRecord) == 112, "binary record layout changed");
+
+// "Clients.txt" -> "Clients.bin"
+inline string binaryFileNameFor(const string &fileName)
+{
+    return replaceFileExtension(fileName, ".bin");
+}
+
+inline off_t binaryRecordOffset(uint64_t slot)
+{
+    return sizeof(sBinaryFileHeader) + slot * sizeof(sBinaryClientRecord);
+}
+
+inline void copyToFixedField(char *field, size_t capacity, string_view value)
+{
+    memset(field, 0, capacity);
+    memcpy(field, value.data(), min(capacity, value.size()));
+}
+
+inline string_view readFixedField(const char *field, size_t capacity)
+{
+    return string_view(field, strnlen(field, capacity));
+}
+
+// Fills the fixed-width record; returns false if a field does not fit its capacity
+inline bool packBinaryFields(string_view accountNumber, string_view pinCode, string_view fullName, string_view phone, sMoney balance,
+                      bool deleted, sBinaryClientRecord &record)
+{
+    if (accountNumber.size() > sizeof(record.accountNumber) || pinCode.size() > sizeof(record.pinCode) ||
+        phone.size() > sizeof(record.phone) || fullName.size() > sizeof(record.fullName))
+        return false;
+
+    memset(&record, 0, sizeof(record));
+    record.accountBalance = balance.cents;
+    record.status = deleted ? binaryRecordDeleted : binaryRecordLive;
+    copyToFixedField(record.pinCode, sizeof(record.pinCode), pinCode);
+    copyToFixedField(record.phone, sizeof(record.phone), phone);
+    copyToFixedField(record.accountNumber, sizeof(record.accountNumber), accountNumber);
+    copyToFixedField(record.fullName, sizeof(record.fullName), fullName);
+    return true;
+}
+
+inline bool packBinaryRecord(const sClient &client, sBinaryClientRecord &record)
+{
+    return packBinaryFields(client.accountNumber, client.pinCode, client.fullName, client.phone, client.accountBalance,
+                            client.markedForDelete, record);
+}
+
+// The record of the client in 'slot' (deleted or not)
+inline bool packSlotRecord(const sClientSlots &slots, size_t slot, sBinaryClientRecord &record)
+{
+    return packBinaryFields(slotAccountNumber(slots, slot), compactPinCode(slots.records[slot]), slotFullName(slots, slot),
+                            compactPhone(slots.records[slot]), slots.balances[slot], isSlotDeleted(slots, slot), record);
+}
+
+// Appends the record as a new slot ('balance' instead of the record's own, for version 1 files)
+inline void appendBinaryRecord(sClientSlots &slots, const sBinaryClientRecord &record, sMoney balance)
+{
+    appendClientSlot(slots, readFixedField(record.accountNumber, sizeof(record.accountNumber)),
+                     readFixedField(record.pinCode, sizeof(record.pinCode)), readFixedField(record.fullName, sizeof(record.fullName)),
+                     readFixedField(record.phone, sizeof(record.phone)), balance);
+    slots.deleted.back() = (record.status == binaryRecordDeleted);
+}
+
+inline bool pwriteAll(int fd, const void *data, size_t size, off_t offset)
+{
+    const char *bytes = static_cast<const char *>(data);
+    while (size > 0)
+    {
+        ssize_t n = pwrite(fd, bytes, size, offset);
+        if (n <= 0)
+            return false;
+        bytes += n;
+        size -= n;
+        offset += n;
+    }
+    return true;
+}
+
+// Writes a complete binary file holding the live clients (to "<file>.tmp", renamed over the file once complete);
+// returns the number of clients written or -1
+inline long long writeBinaryClientsFile(const string &binaryFileName, const sClientSlots &slots)
+{
+    ofstream myFile(temporaryFileNameFor(binaryFileName), ios::out | ios::binary | ios::trunc);
+    if (!myFile.is_open())
+    {
+        cerr << "Error: Could not open file '" << temporaryFileNameFor(binaryFileName) << "' for writing.\n";
+        return -1;
+    }
+
+    sBinaryFileHeader header = {};
+    memcpy(header.magic, binaryFileMagic, sizeof(header.magic));
+    header.version = binaryFileVersion;
+    header.recordSize = sizeof(sBinaryClientRecord);
+    myFile.write(reinterpret_cast<const char *>(&header), sizeof(header));
+
+    sBinaryClientRecord record;
+    for (size_t slot = 0; slot < slotCount(slots); slot++)
+    {
+        if (isSlotDeleted(slots, slot))
+            continue;
+        if (!packSlotRecord(slots, slot, record))
+        {
+            cerr << "Warning: client [" << slotAccountNumber(slots, slot) << "] does not fit the binary record and was skipped.\n";
+            continue;
+        }
+        myFile.write(reinterpret_cast<const char *>(&record), sizeof(record));
+        header.recordCount++;
+    }
+
+    // now that the count is known, rewrite the header
+    myFile.seekp(0);
+    myFile.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    myFile.close();
+    if (!myFile || !replaceWithTemporaryFile(binaryFileName))
+        return -1;
+    return static_cast<long long>(header.recordCount);
+}
+
+// Loads every record (deleted ones included, so slot n stays record n); returns false if the file is invalid.
+// 'version' is set to the version of the file (binaryFileVersionWithDoubles needs converting before it is written).
+inline bool readBinaryClientsFile(const string &binaryFileName, sClientSlots &slots, uint32_t *version = nullptr)
+{
+    slots = sClientSlots();
+
+    sMappedFile mapped;
+    if (!mapFile(binaryFileName, mapped))
+    {
+        cerr << "Error: Could not open file '" << binaryFileName << "' for reading.\n";
+        return false;
+    }
+
+    sBinaryFileHeader header;
+    bool valid = mapped.size >= sizeof(header);
+    if (valid)
+    {
+        memcpy(&header, mapped.data, sizeof(header));
+        valid = memcmp(header.magic, binaryFileMagic, sizeof(header.magic)) == 0 &&
+                (header.version == binaryFileVersion || header.version == binaryFileVersionWithDoubles) &&
+                header.recordSize == sizeof(sBinaryClientRecord) &&
+                mapped.size >= static_cast<size_t>(binaryRecordOffset(header.recordCount));
+    }
+    if (!valid)
+    {
+        cerr << "Error: '" << binaryFileName << "' is not a valid version " << binaryFileVersion << " clients file.\n";
+        unmapFile(mapped);
+        return false;
+    }
+
+    reserveClientSlots(slots, header.recordCount);
+    sBinaryClientRecord record;
+    for (uint64_t slot = 0; slot < header.recordCount; slot++)
+    {
+        memcpy(&record, mapped.data + binaryRecordOffset(slot), sizeof(record));
+        sMoney balance{record.accountBalance};
+        if (header.version == binaryFileVersionWithDoubles)
+        {
+            double doubleBalance;
+            memcpy(&doubleBalance, &record.accountBalance, sizeof(doubleBalance));
+            balance = moneyFromDouble(doubleBalance);
+        }
+        appendBinaryRecord(slots, record, balance);
+    }
+
+    if (version != nullptr)
+        *version = header.version;
+    unmapFile(mapped);
+    return true;
+}
+
+inline bool openBinaryStorage(sBinaryStorage &binary, const string &clientsFileName)
+{
+    string binaryFileName = binaryFileNameFor(clientsFileName);
+    if (binary.fd != -1 && binary.fileName == binaryFileName)
+        return true;
+    if (binary.fd != -1)
+        close(binary.fd);
+
+    binary.fileName = binaryFileName;
+    binary.fd = open(binaryFileName.c_str(), O_RDWR | O_CREAT, 0644);
+    if (binary.fd == -1)
+    {
+        cerr << "Error: Could not open file '" << binaryFileName << "' for writing.\n";
+        return false;
+    }
+
+    // a file that did not exist yet starts as a valid empty one, so the records written next can be read back
+    struct stat info;
+    if (fstat(binary.fd, &info) == 0 && info.st_size == 0)
+    {
+        sBinaryFileHeader header = {};
+        memcpy(header.magic, binaryFileMagic, sizeof(header.magic));
+        header.version = binaryFileVersion;
+        header.recordSize = sizeof(sBinaryClientRecord);
+        header.recordCount = binary.recordCount = 0;
+        if (!pwriteAll(binary.fd, &header, sizeof(header), 0) || fsync(binary.fd) != 0)
+        {
+            cerr << "Error: Could not write file '" << binaryFileName << "'.\n";
+            close(binary.fd);
+            binary.fd = -1;
+            return false;
+        }
+        fsyncParentDirectory(binaryFileName);
+        return true;
+    }
+
+    // in-place writes store cents, which must never land in a version 1 file of doubles
+    sBinaryFileHeader header;
+    if (pread(binary.fd, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header)) || header.version != binaryFileVersion)
+    {
+        cerr << "Error: '" << binaryFileName << "' is not a version " << binaryFileVersion << " clients file; it is not written to.\n";
+        close(binary.fd);
+        binary.fd = -1;
+        return false;
+    }
+    return true;
+}
+
+// Overwrites only the balance of record 'slot'
+inline bool writeBinaryBalance(sBinaryStorage &binary, uint64_t slot, sMoney money)
+{
+    int64_t balance = money.cents;
+    off_t offset = binaryRecordOffset(slot) + offsetof(sBinaryClientRecord, accountBalance);
+    return pwriteAll(binary.fd, &balance, sizeof(balance), offset);
+}
+
+// Flags record 'slot' as deleted (a one-byte tombstone)
+inline bool writeBinaryTombstone(sBinaryStorage &binary, uint64_t slot)
+{
+    off_t offset = binaryRecordOffset(slot) + offsetof(sBinaryClientRecord, status);
+    return pwriteAll(binary.fd, &binaryRecordDeleted, sizeof(binaryRecordDeleted), offset);
+}
+
+// Overwrites the whole record 'slot'; appending (slot == recordCount) also bumps the count in the header
+inline bool writeBinaryRecord(sBinaryStorage &binary, uint64_t slot, const sClient &client)
+{
+    sBinaryClientRecord record;
+    if (!packBinaryRecord(client, record))
+        return false;
+    if (!pwriteAll(binary.fd, &record, sizeof(record), binaryRecordOffset(slot)))
+        return false;
+
+    if (slot >= binary.recordCount)
+    {
+        binary.recordCount = slot + 1;
+        uint64_t count = binary.recordCount;
+        return pwriteAll(binary.fd, &count, sizeof(count), offsetof(sBinaryFileHeader, recordCount));
+    }
+    return true;
+}
+
+inline void detectShardedStorage(const string &fileName, sClientStore &store);
+
+// --to-binary: Clients.txt or the shard files (+ the operation log) -> Clients.bin
+inline void convertTextToBinary(string fileName, string delim)
+{
+    sClientStore store;
+    detectShardedStorage(fileName, store);
+    loadClientStore(fileName, delim, store);
+
+    long long written = writeBinaryClientsFile(binaryFileNameFor(fileName), store.clients);
+    if (written >= 0)
+        cout << written << " client(s) written to '" << binaryFileNameFor(fileName) << "'.\n";
+}
+
+// --to-text: Clients.bin -> Clients.txt (the operation log is emptied, Clients.bin already holds every change)
+inline void convertBinaryToText(string fileName, string delim)
+{
+    sClientSlots slots;
+    if (!readBinaryClientsFile(binaryFileNameFor(fileName), slots))
+        return;
+
+    if (!writeFileAtomically(fileName, formatClientsFileContents(slots, delim)) ||
+        !writeFileAtomically(operationLogNameFor(fileName), ""))
+        return;
+    unlink(retiredLogNameFor(fileName).c_str());
+
+    size_t written = count(slots.deleted.begin(), slots.deleted.end(), 0);
+    cout << written << " client(s) written to '" << fileName << "'.\n";
+}
+
+// *****************************************************************************************************************
+
+// ------------------------------------------------------ INDEX FILE (B+TREE) ------------------------------------------------------
+// *****************************************************************************************************************
+// Clients.idx is a B+tree of 4 KB pages from account number to the client's current line: a byte range in
+// Clients.txt, or in Clients.log once the client was added or changed after the last compaction.
+// FIND / UPDATE / DELETE on a store that was never loaded read one page per tree level plus that line.
+// The header remembers which Clients.txt the tree was built from (size + mtime) and how much of Clients.log
+// it already covers: a newer log tail is applied to the tree when it is opened, and a rewritten Clients.txt
+// (compaction, conversion) rebuilds it in bulk. Deletes do not merge underfull pages; a rebuild packs them.
+// Pages are changed in place, so before the first change the header is flagged (and synced) as changing,
+// and the flag is only cleared once the pages are synced when the index is closed. A tree found flagged,
+// or whose header does not match the file, may be half written after a crash and is rebuilt.
+
+const char indexFileMagic[4] = {'B', 'I', 'D', 'X'};
+const uint32_t indexFileVersion = 1;
+const uint32_t indexPageSize = 4096;
+const uint64_t indexLocationInLog = 1ULL << 63; // location flag: the line is in Clients.log, not Clients.txt
+
+struct sIndexFileHeader // page 0
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t pageSize;
+    uint32_t rootPage;
+    uint32_t pageCount;
+    uint32_t changing; // 1 from the first in-place page write until the index is closed cleanly
+    uint64_t entryCount;
+    uint64_t dataBytes;
+    int64_t dataModified;
+    uint64_t logBytes;
+};
+
+struct sIndexLeafEntry
+{
+    char accountNumber[accountNumberCapacity]; // zero-padded, so memcmp orders keys like strings
+    uint32_t length;                           // bytes in the client line
+    uint64_t location;                         // offset of the client line (| indexLocationInLog)
+};
+
+struct sIndexBranchEntry
+{
+    char accountNumber[accountNumberCapacity]; // smallest key stored under 'child'
+    uint32_t child;
+};
+
+const size_t indexLeafCapacity = (indexPageSize - 16) / sizeof(sIndexLeafEntry);     // 127
+const size_t indexBranchCapacity = (indexPageSize - 16) / sizeof(sIndexBranchEntry); // 170
+
+struct sIndexPage
+{
+    uint16_t isLeaf;
+    uint16_t count;
+    uint32_t link; // leaf: next leaf (0 = last); branch: child holding the keys below branch[0]
+    uint8_t reserved[8];
+    union
+    {
+        sIndexLeafEntry leaf[indexLeafCapacity];
+        sIndexBranchEntry branch[indexBranchCapacity];
+    };
+};
+
+static_assert(sizeof(sIndexPage) == indexPageSize, "an index page must be exactly one page");
+
+inline string indexFileNameFor(const string &fileName)
+{
+    return replaceFileExtension(fileName, ".idx");
+}
+
+// Returns false if the account number is too long to ever be in the index
+inline bool makeIndexKey(string_view accountNumber, char key[accountNumberCapacity])
+{
+    if (accountNumber.size() > static_cast<size_t>(accountNumberCapacity))
+        return false;
+    memset(key, 0, accountNumberCapacity);
+    memcpy(key, accountNumber.data(), accountNumber.size());
+    return true;
+}
+
+inline int compareIndexKeys(const char *a, const char *b)
+{
+    return memcmp(a, b, accountNumberCapacity);
+}
+
+inline bool readIndexPage(const sIndexFile &index, uint32_t pageNumber, sIndexPage &page)
+{
+    return pread(index.fd, &page, indexPageSize, static_cast<off_t>(pageNumber) * indexPageSize) == static_cast<ssize_t>(indexPageSize);
+}
+
+inline bool writeIndexPage(sIndexFile &index, uint32_t pageNumber, const sIndexPage &page)
+{
+    return pwriteAll(index.fd, &page, indexPageSize, static_cast<off_t>(pageNumber) * indexPageSize);
+}
+
+inline bool writeIndexFileHeader(sIndexFile &index)
+{
+    sIndexFileHeader header = {};
+    memcpy(header.magic, indexFileMagic, sizeof(header.magic));
+    header.version = indexFileVersion;
+    header.pageSize = indexPageSize;
+    header.rootPage = index.rootPage;
+    header.pageCount = index.pageCount;
+    header.changing = index.changing;
+    header.entryCount = index.entryCount;
+    header.dataBytes = index.dataBytes;
+    header.dataModified = index.dataModified;
+    header.logBytes = index.logBytes;
+    return pwriteAll(index.fd, &header, sizeof(header), 0);
+}
+
+// Flags the header before this process changes its first page, so a crash from now on is noticed
+inline bool beginIndexFileChanges(sIndexFile &index)
+{
+    if (index.changing)
+        return true;
+    index.changing = true;
+    return writeIndexFileHeader(index) && syncFileData(index.fd) == 0;
+}
+
+// Syncs the pages, clears the header's 'changing' flag and closes the file
+inline void closeIndexFile(sIndexFile &index)
+{
+    if (index.fd == -1)
+        return;
+    if (index.changing && syncFileData(index.fd) == 0)
+    {
+        index.changing = false;
+        if (writeIndexFileHeader(index))
+            syncFileData(index.fd);
+    }
+    close(index.fd);
+    index.fd = -1;
+}
+
+inline sIndexFile::~sIndexFile()
+{
+    closeIndexFile(*this);
+}
+
+// Size and modification time (ns) of a file; a missing file counts as empty
+inline void getFileVersion(const string &fileName, uint64_t &bytes, int64_t &modified)
+{
+    struct stat info;
+    if (stat(fileName.c_str(), &info) == -1)
+    {
+        bytes = 0;
+        modified = 0;
+        return;
+    }
+    bytes = info.st_size;
+    modified = fileModifiedNanoseconds(info);
+}
+
+// Position of the first leaf entry whose key is >= 'key'
+inline size_t lowerBoundInLeaf(const sIndexPage &page, const char *key)
+{
+    size_t low = 0, high = page.count;
+    while (low < high)
+    {
+        size_t middle = (low + high) / 2;
+        if (compareIndexKeys(page.leaf[middle].accountNumber, key) < 0)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low;
+}
+
+// Number of branch entries whose key is <= 'key' (0 means the key belongs under page.link)
+inline size_t upperBoundInBranch(const sIndexPage &page, const char *key)
+{
+    size_t low = 0, high = page.count;
+    while (low < high)
+    {
+        size_t middle = (low + high) / 2;
+        if (compareIndexKeys(page.branch[middle].accountNumber, key) <= 0)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low;
+}
+
+inline uint32_t childForKey(const sIndexPage &page, const char *key)
+{
+    size_t position = upperBoundInBranch(page, key);
+    return position == 0 ? page.link : page.branch[position - 1].child;
+}
+
+// Walks from the root to the leaf that holds (or would hold) the key; one page read per level
+inline bool findLeafInIndexFile(const sIndexFile &index, const char *key, uint32_t &pageNumber, sIndexPage &page)
+{
+    pageNumber = index.rootPage;
+    while (readIndexPage(index, pageNumber, page))
+    {
+        if (page.isLeaf)
+            return true;
+        pageNumber = childForKey(page, key);
+    }
+    return false;
+}
+
+inline bool findInIndexFile(const sIndexFile &index, string_view accountNumber, sIndexLeafEntry &entry)
+{
+    char key[accountNumberCapacity];
+    uint32_t pageNumber;
+    sIndexPage page;
+    if (!makeIndexKey(accountNumber, key) || !findLeafInIndexFile(index, key, pageNumber, page))
+        return false;
+
+    size_t position = lowerBoundInLeaf(page, key);
+    if (position == page.count || compareIndexKeys(page.leaf[position].accountNumber, key) != 0)
+        return false;
+    entry = page.leaf[position];
+    return true;
+}
+
+// Inserts or replaces the entry under 'pageNumber'. If the page had to split, 'split' is set to the
+// new right-hand page and its smallest key, for the caller to add to the parent.
+inline bool insertIntoIndexPage(sIndexFile &index, uint32_t pageNumber, const sIndexLeafEntry &entry, optional<sIndexBranchEntry> &split)
+{
+    split.reset();
+    sIndexPage page;
+    if (!readIndexPage(index, pageNumber, page))
+        return false;
+
+    if (page.isLeaf)
+    {
+        size_t position = lowerBoundInLeaf(page, entry.accountNumber);
+        if (position < page.count && compareIndexKeys(page.leaf[position].accountNumber, entry.accountNumber) == 0)
+        {
+            page.leaf[position] = entry;
+            return writeIndexPage(index, pageNumber, page);
+        }
+        index.entryCount++;
+
+        if (page.count < indexLeafCapacity)
+        {
+            memmove(&page.leaf[position + 1], &page.leaf[position], (page.count - position) * sizeof(sIndexLeafEntry));
+            page.leaf[position] = entry;
+            page.count++;
+            return writeIndexPage(index, pageNumber, page);
+        }
+
+        // full leaf: the lower half stays, the upper half moves to a new leaf
+        vector<sIndexLeafEntry> all(page.leaf, page.leaf + page.count);
+        all.insert(all.begin() + position, entry);
+
+        sIndexPage right = {};
+        right.isLeaf = 1;
+        page.count = all.size() / 2;
+        right.count = all.size() - page.count;
+        memcpy(page.leaf, all.data(), page.count * sizeof(sIndexLeafEntry));
+        memcpy(right.leaf, all.data() + page.count, right.count * sizeof(sIndexLeafEntry));
+
+        uint32_t rightNumber = index.pageCount++;
+        right.link = page.link;
+        page.link = rightNumber;
+
+        sIndexBranchEntry separator;
+        memcpy(separator.accountNumber, right.leaf[0].accountNumber, accountNumberCapacity);
+        separator.child = rightNumber;
+        split = separator;
+        return writeIndexPage(index, rightNumber, right) && writeIndexPage(index, pageNumber, page);
+    }
+
+    size_t position = upperBoundInBranch(page, entry.accountNumber);
+    uint32_t child = (position == 0) ? page.link : page.branch[position - 1].child;
+    optional<sIndexBranchEntry> childSplit;
+    if (!insertIntoIndexPage(index, child, entry, childSplit))
+        return false;
+    if (!childSplit)
+        return true;
+
+    if (page.count < indexBranchCapacity)
+    {
+        memmove(&page.branch[position + 1], &page.branch[position], (page.count - position) * sizeof(sIndexBranchEntry));
+        page.branch[position] = *childSplit;
+        page.count++;
+        return writeIndexPage(index, pageNumber, page);
+    }
+
+    // full branch: the middle key moves up, its child becomes the new page's first child
+    vector<sIndexBranchEntry> all(page.branch, page.branch + page.count);
+    all.insert(all.begin() + position, *childSplit);
+
+    size_t middle = all.size() / 2;
+    sIndexPage right = {};
+    right.isLeaf = 0;
+    right.link = all[middle].child;
+    right.count = all.size() - middle - 1;
+    memcpy(right.branch, all.data() + middle + 1, right.count * sizeof(sIndexBranchEntry));
+    page.count = middle;
+    memcpy(page.branch, all.data(), page.count * sizeof(sIndexBranchEntry));
+
+    uint32_t rightNumber = index.pageCount++;
+    sIndexBranchEntry separator = all[middle];
+    separator.child = rightNumber;
+    split = separator;
+    return writeIndexPage(index, rightNumber, right) && writeIndexPage(index, pageNumber, page);
+}
+
+// Adds or replaces the location of one client line
+inline bool insertIntoIndexFile(sIndexFile &index, string_view accountNumber, uint64_t location, uint32_t length)
+{
+    sIndexLeafEntry entry;
+    if (!makeIndexKey(accountNumber, entry.accountNumber))
+        return false;
+    entry.length = length;
+    entry.location = location;
+
+    optional<sIndexBranchEntry> split;
+    if (!insertIntoIndexPage(index, index.rootPage, entry, split))
+        return false;
+
+    if (split)
+    {
+        // the root split: the tree grows one level
+        sIndexPage root = {};
+        root.isLeaf = 0;
+        root.link = index.rootPage;
+        root.count = 1;
+        root.branch[0] = *split;
+        index.rootPage = index.pageCount++;
+        if (!writeIndexPage(index, index.rootPage, root))
+            return false;
+    }
+    return true;
+}
+
+inline bool eraseFromIndexFile(sIndexFile &index, string_view accountNumber)
+{
+    char key[accountNumberCapacity];
+    uint32_t pageNumber;
+    sIndexPage page;
+    if (!makeIndexKey(accountNumber, key) || !findLeafInIndexFile(index, key, pageNumber, page))
+        return false;
+
+    size_t position = lowerBoundInLeaf(page, key);
+    if (position == page.count || compareIndexKeys(page.leaf[position].accountNumber, key) != 0)
+        return false;
+
+    memmove(&page.leaf[position], &page.leaf[position + 1], (page.count - position - 1) * sizeof(sIndexLeafEntry));
+    page.count--;
+    index.entryCount--;
+    return writeIndexPage(index, pageNumber, page);
+}
+
+// Writes a new tree holding 'entries' (sorted, unique keys): full leaves left to right, then each
+// level of branches above them, so the whole build is one sequential write
+inline bool bulkLoadIndexFile(sIndexFile &index, const vector<sIndexLeafEntry> &entries)
+{
+    index.pageCount = 1; // page 0 is the header
+    vector<sIndexBranchEntry> level; // smallest key and page number of every node on the level below
+
+    size_t next = 0;
+    do
+    {
+        sIndexPage leaf = {};
+        leaf.isLeaf = 1;
+        leaf.count = min(indexLeafCapacity, entries.size() - next);
+        memcpy(leaf.leaf, entries.data() + next, leaf.count * sizeof(sIndexLeafEntry));
+
+        sIndexBranchEntry node = {};
+        if (leaf.count > 0)
+            memcpy(node.accountNumber, leaf.leaf[0].accountNumber, accountNumberCapacity);
+        node.child = index.pageCount++;
+        next += leaf.count;
+        leaf.link = (next < entries.size()) ? node.child + 1 : 0;
+
+        if (!writeIndexPage(index, node.child, leaf))
+            return false;
+        level.push_back(node);
+    } while (next < entries.size());
+
+    while (level.size() > 1)
+    {
+        vector<sIndexBranchEntry> parents;
+        for (size_t first = 0; first < level.size(); first += indexBranchCapacity + 1)
+        {
+            sIndexPage branch = {};
+            branch.isLeaf = 0;
+            branch.link = level[first].child;
+            branch.count = min(indexBranchCapacity, level.size() - first - 1);
+            memcpy(branch.branch, level.data() + first + 1, branch.count * sizeof(sIndexBranchEntry));
+
+            sIndexBranchEntry node = level[first];
+            node.child = index.pageCount++;
+            if (!writeIndexPage(index, node.child, branch))
+                return false;
+            parents.push_back(node);
+        }
+        level.swap(parents);
+    }
+
+    index.rootPage = level[0].child;
+    index.entryCount = entries.size();
+    return ftruncate(index.fd, static_cast<off_t>(index.pageCount) * indexPageSize) == 0;
+}
+
+// The first client line of a TRANSFER payload ends at its 5th delimiter, the second one follows it
+inline bool splitTransferPayload(string_view payload, string_view delim, string_view &first, string_view &second)
+{
+    size_t end = 0;
+    for (short n = 0; n < 5 && end != string_view::npos; n++)
+        end = simdFind(payload, delim, n == 0 ? 0 : end + delim.length());
+    if (end == string_view::npos)
+        return false;
+
+    first = payload.substr(0, end);
+    second = payload.substr(end + delim.length());
+    return true;
+}
+
+// Points the index at a client line that starts 'offset' bytes into the log
+inline bool indexClientLineInLog(sIndexFile &index, string_view clientLine, string_view delim, uint64_t offset)
+{
+    string_view accountNumber = clientLine.substr(0, simdFind(clientLine, delim));
+    return insertIntoIndexFile(index, accountNumber, offset | indexLocationInLog, clientLine.size());
+}
+
+// Applies the log records written after the part the tree already covers.
+// An incomplete last line is left for the next call.
+inline bool applyLogTailToIndexFile(sIndexFile &index, const string &fileName, string delim)
+{
+    uint64_t logBytes;
+    int64_t logModified;
+    string logFileName = operationLogNameFor(fileName);
+    getFileVersion(logFileName, logBytes, logModified);
+    if (logBytes <= index.logBytes)
+        return true;
+    if (!beginIndexFileChanges(index))
+        return false;
+
+    int fd = open(logFileName.c_str(), O_RDONLY);
+    if (fd == -1)
+        return false;
+    string tail(logBytes - index.logBytes, '\0');
+    ssize_t got = pread(fd, tail.data(), tail.size(), index.logBytes);
+    close(fd);
+    if (got != static_cast<ssize_t>(tail.size()))
+        return false;
+
+    size_t lineStart = 0, lineEnd;
+    while ((lineEnd = tail.find('\n', lineStart)) != string::npos)
+    {
+        string_view line(tail.data() + lineStart, lineEnd - lineStart);
+        uint64_t lineOffset = index.logBytes + lineStart;
+        lineStart = lineEnd + 1;
+
+        size_t pos = simdFind(line, delim);
+        if (pos == string_view::npos)
+            continue;
+        string_view operation = line.substr(0, pos);
+        string_view payload = line.substr(pos + delim.length());
+        uint64_t payloadOffset = lineOffset + pos + delim.length();
+
+        if (operation == logDelete)
+            eraseFromIndexFile(index, payload);
+        else if (operation == logAdd || operation == logUpdate)
+            indexClientLineInLog(index, payload, delim, payloadOffset);
+        else if (operation == logTransfer)
+        {
+            string_view first, second;
+            if (splitTransferPayload(payload, delim, first, second))
+            {
+                indexClientLineInLog(index, first, delim, payloadOffset);
+                indexClientLineInLog(index, second, delim, payloadOffset + (second.data() - payload.data()));
+            }
+        }
+    }
+
+    index.logBytes += lineStart;
+    return writeIndexFileHeader(index);
+}
+
+// Rebuilds the tree from Clients.txt (one sequential scan, no clients materialized), then applies the whole log
+inline bool rebuildClientIndexFile(string fileName, string delim, sIndexFile &index)
+{
+    if (index.fd == -1)
+    {
+        index.fileName = indexFileNameFor(fileName);
+        index.fd = open(index.fileName.c_str(), O_RDWR | O_CREAT, 0644);
+        if (index.fd == -1)
+        {
+            cerr << "Error: Could not open file '" << index.fileName << "'.\n";
+            return false;
+        }
+    }
+
+    getFileVersion(fileName, index.dataBytes, index.dataModified);
+
+    vector<sIndexLeafEntry> entries;
+    sMappedFile mapped;
+    if (mapFile(fileName, mapped))
+    {
+        entries.reserve(mapped.size / 48);
+        const char *end = mapped.data + mapped.size;
+        for (const char *lineStart = mapped.data; lineStart < end;)
+        {
+            const char *lineEnd = static_cast<const char *>(memchr(lineStart, '\n', end - lineStart));
+            if (lineEnd == nullptr)
+                lineEnd = end;
+
+            string_view line(lineStart, lineEnd - lineStart);
+            if (!line.empty() && line.back() == '\r')
+                line.remove_suffix(1);
+
+            sIndexLeafEntry entry;
+            if (!line.empty() && makeIndexKey(line.substr(0, simdFind(line, delim)), entry.accountNumber))
+            {
+                entry.location = lineStart - mapped.data;
+                entry.length = line.size();
+                entries.push_back(entry);
+            }
+            lineStart = lineEnd + 1;
+        }
+        unmapFile(mapped);
+    }
+
+    // the base file never repeats an account, but if it does the later line wins, like when loading
+    stable_sort(entries.begin(), entries.end(), [](const sIndexLeafEntry &a, const sIndexLeafEntry &b)
+                { return compareIndexKeys(a.accountNumber, b.accountNumber) < 0; });
+    auto sameKey = [](const sIndexLeafEntry &a, const sIndexLeafEntry &b)
+    { return compareIndexKeys(a.accountNumber, b.accountNumber) == 0; };
+    vector<sIndexLeafEntry> unique;
+    unique.reserve(entries.size());
+    for (size_t i = 0; i < entries.size(); i++)
+    {
+        if (i + 1 == entries.size() || !sameKey(entries[i], entries[i + 1]))
+            unique.push_back(entries[i]);
+    }
+
+    index.logBytes = 0;
+    return beginIndexFileChanges(index) && bulkLoadIndexFile(index, unique) && writeIndexFileHeader(index) &&
+           applyLogTailToIndexFile(index, fileName, delim);
+}
+
+// Opens Clients.idx if it is not open yet and reads its header; false if the file is missing (and not created),
+// flagged as changing or does not match its own size. An index that was not opened leaves 'fd' at -1.
+inline bool openIndexFileHeader(string fileName, sIndexFile &index, bool create)
+{
+    if (index.fd != -1)
+        return true; // checked (or rebuilt) when it was opened, and kept up to date since
+
+    index.fileName = indexFileNameFor(fileName);
+    index.fd = open(index.fileName.c_str(), O_RDWR | (create ? O_CREAT : 0), 0644);
+    if (index.fd == -1)
+    {
+        if (create)
+            cerr << "Error: Could not open file '" << index.fileName << "'.\n";
+        return false;
+    }
+
+    sIndexFileHeader header;
+    struct stat info;
+    if (pread(index.fd, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header)) &&
+        memcmp(header.magic, indexFileMagic, sizeof(header.magic)) == 0 && header.version == indexFileVersion &&
+        header.pageSize == indexPageSize && header.changing == 0 && fstat(index.fd, &info) == 0 &&
+        static_cast<uint64_t>(info.st_size) == static_cast<uint64_t>(header.pageCount) * indexPageSize &&
+        header.rootPage > 0 && header.rootPage < header.pageCount)
+    {
+        index.rootPage = header.rootPage;
+        index.pageCount = header.pageCount;
+        index.entryCount = header.entryCount;
+        index.dataBytes = header.dataBytes;
+        index.dataModified = header.dataModified;
+        index.logBytes = header.logBytes;
+        return true;
+    }
+    if (!create)
+    {
+        close(index.fd);
+        index.fd = -1;
+    }
+    return false;
+}
+
+// True while a compaction (of this process, or one that never finished) moves records from Clients.log into
+// Clients.txt: the files are in between, so the index is not used until it is over
+inline bool isCompactionInFlight(string fileName, sClientStore &store)
+{
+    {
+        lock_guard<mutex> guard(store.fileFlusher.lock);
+        if (!store.fileFlusher.retiredLogName.empty() || !store.fileFlusher.pendingFiles.empty() || store.fileFlusher.busy)
+            return true;
+    }
+    return access(retiredLogNameFor(fileName).c_str(), F_OK) == 0;
+}
+
+// Opens Clients.idx for a lookup, which neither waits nor writes: true only if the tree already covers
+// Clients.txt and all of Clients.log. Otherwise the caller loads the store instead.
+inline bool openCurrentClientIndexFile(string fileName, sClientStore &store)
+{
+    sIndexFile &index = store.indexFile;
+    if (isCompactionInFlight(fileName, store) || !openIndexFileHeader(fileName, index, false))
+        return false;
+
+    uint64_t dataBytes, logBytes;
+    int64_t dataModified, logModified;
+    getFileVersion(fileName, dataBytes, dataModified);
+    getFileVersion(operationLogNameFor(fileName), logBytes, logModified);
+    return dataBytes == index.dataBytes && dataModified == index.dataModified && logBytes == index.logBytes;
+}
+
+// Opens Clients.idx for a write through it and brings it up to date: rebuilt if missing or built from another
+// Clients.txt, otherwise only the new log tail is applied. False during a compaction (the caller loads the store).
+inline bool openClientIndexFile(string fileName, string delim, sClientStore &store)
+{
+    sIndexFile &index = store.indexFile;
+    if (isCompactionInFlight(fileName, store))
+        return false;
+    bool valid = openIndexFileHeader(fileName, index, true);
+    if (index.fd == -1)
+        return false;
+
+    uint64_t dataBytes, logBytes;
+    int64_t dataModified, logModified;
+    getFileVersion(fileName, dataBytes, dataModified);
+    getFileVersion(operationLogNameFor(fileName), logBytes, logModified);
+
+    if (!valid || dataBytes != index.dataBytes || dataModified != index.dataModified || logBytes < index.logBytes)
+        return rebuildClientIndexFile(fileName, delim, index);
+    return applyLogTailToIndexFile(index, fileName, delim);
+}
+
+// At the end of an interactive session: builds Clients.idx, or brings it up to date with what the session wrote
+// (usually a short log tail), so that the next session's lookups can use it; they never fix a stale index themselves
+inline void updateClientIndexFileAtExit(string fileName, string delim, sClientStore &store)
+{
+    if (store.storageFormat != TextStorage)
+        return;
+    waitForClientsFileRewrites(store.fileFlusher);
+    openClientIndexFile(fileName, delim, store);
+}
+
+// Startup: puts the records of a compaction that never finished back into Clients.log, so that the index can
+// follow the log again. Done once here, never on the lookup path.
+inline void recoverInterruptedCompaction(string fileName, sClientStore &store)
+{
+    if (store.storageFormat == TextStorage)
+        restoreRetiredOperationLog(fileName, store);
+}
+
+// Keeps an already opened index in step with the records just appended to the log
+inline void updateClientIndexFileIfOpen(string fileName, string delim, sClientStore &store)
+{
+    if (store.indexFile.fd != -1)
+        applyLogTailToIndexFile(store.indexFile, fileName, delim);
+}
+
+// Reads the one client line an index entry points to
+inline bool readClientAtIndexEntry(string fileName, string delim, const sIndexLeafEntry &entry, sClient &client)
+{
+    bool inLog = (entry.location & indexLocationInLog) != 0;
+    string sourceFileName = inLog ? operationLogNameFor(fileName) : fileName;
+    int fd = open(sourceFileName.c_str(), O_RDONLY);
+    if (fd == -1)
+        return false;
+
+    string line(entry.length, '\0');
+    ssize_t got = pread(fd, line.data(), line.size(), entry.location & ~indexLocationInLog);
+    close(fd);
+    return got == static_cast<ssize_t>(line.size()) && parseClientLine(line, delim, client);
+}
+
+// FIND without a loaded store; the caller opened the index with openCurrentClientIndexFile
+inline bool findClientThroughIndexFile(string fileName, string delim, const string &accountNumber, sClientStore &store, sClient &client)
+{
+    sIndexLeafEntry entry;
+    return findInIndexFile(store.indexFile, accountNumber, entry) && readClientAtIndexEntry(fileName, delim, entry, client);
+}
+
+// UPDATE without a loaded store: append the record, then point the index at it (opened with openClientIndexFile)
+inline bool updateClientThroughIndexFile(string fileName, string delim, const sClient &client, sClientStore &store)
+{
+    sIndexLeafEntry entry;
+    if (!findInIndexFile(store.indexFile, client.accountNumber, entry))
+        return false;
+
+    logClientUpdated(fileName, delim, client, store);
+    bool indexed = applyLogTailToIndexFile(store.indexFile, fileName, delim);
+    compactOperationLogIfNeeded(fileName, delim, store); // the flusher rebuilds the index if it compacts
+    return indexed;
+}
+
+// DELETE without a loaded store: append the record, then drop the key from the index (opened with openClientIndexFile)
+inline bool deleteClientThroughIndexFile(string fileName, string delim, const string &accountNumber, sClientStore &store)
+{
+    sIndexLeafEntry entry;
+    if (!findInIndexFile(store.indexFile, accountNumber, entry))
+        return false;
+
+    logClientDeleted(fileName, delim, accountNumber, store);
+    bool indexed = applyLogTailToIndexFile(store.indexFile, fileName, delim);
+    compactOperationLogIfNeeded(fileName, delim, store); // the flusher rebuilds the index if it compacts
+    return indexed;
+}
+
+// *****************************************************************************************************************
+
+// ------------------------------------------------------ CHECKPOINTS ------------------------------------------------------
+// *****************************************************************************************************************
+// Clients.ckpt is a binary snapshot of the slots: a 4 KB header, then one fixed-width record per slot (the
+// Clients.bin record layout, deleted clients included as tombstones), grouped in pages of checkpointPageRecords.
+// A checkpoint only rewrites the pages whose slots changed since the previous one, then the header, which names
+// the Clients.txt it was taken over and how far into Clients.log it reaches. Startup maps the snapshot, copies
+// the records out and replays only the log records after it, instead of parsing every line of Clients.txt.
+// A crash in the middle of a checkpoint leaves some pages newer than the old header, which is harmless:
+// every change after the header's log position is replayed on top of them.
+
+// "Clients.txt" -> "Clients.ckpt"
+inline string checkpointFileNameFor(const string &fileName)
+{
+    return replaceFileExtension(fileName, ".ckpt");
+}
+
+inline off_t checkpointRecordOffset(uint64_t slot)
+{
+    return checkpointHeaderSize + slot * sizeof(sBinaryClientRecord);
+}
+
+// Identifies the log and the bytes up to 'logBytes'; false if the log cannot be read that far.
+// A log that does not exist reads as empty (device and inode 0); checking a snapshot never creates it.
+inline bool describeOperationLog(const string &logFileName, uint64_t logBytes, sCheckpointHeader &header)
+{
+    int fd = open(logFileName.c_str(), O_RDONLY);
+    if (fd == -1 && errno == ENOENT)
+    {
+        header.logDevice = 0;
+        header.logInode = 0;
+        header.logBytes = 0;
+        header.logTailHash = hashAccountNumber("");
+        return logBytes == 0;
+    }
+    struct stat info;
+    if (fd == -1 || fstat(fd, &info) == -1 || static_cast<uint64_t>(info.st_size) < logBytes)
+    {
+        if (fd != -1)
+            close(fd);
+        return false;
+    }
+
+    uint64_t start = logBytes - min<uint64_t>(logBytes, checkpointLogTailBytes);
+    string tail(logBytes - start, '\0');
+    bool read = pread(fd, tail.data(), tail.size(), start) == static_cast<ssize_t>(tail.size());
+    close(fd);
+
+    header.logDevice = info.st_dev;
+    header.logInode = info.st_ino;
+    header.logBytes = logBytes;
+    header.logTailHash = hashAccountNumber(tail);
+    return read;
+}
+
+// Clears the header's magic so the snapshot is not used while its pages are renumbered
+inline bool invalidateCheckpointFile(int fd)
+{
+    char zero[sizeof(checkpointFileMagic)] = {};
+    return pwriteAll(fd, zero, sizeof(zero), 0) && syncFileData(fd) == 0;
+}
+
+// Writes the changed pages and the header; returns false (and keeps the pages flagged) if it could not.
+// Callers hold the store exclusively, so no balance changes while the pages are copied.
+inline bool writeCheckpoint(string fileName, sClientStore &store)
+{
+    if (!store.loaded || store.storageFormat != TextStorage)
+        return false;
+
+    sOperationLog &log = store.operationLog;
+    sCheckpointHeader header = {};
+    syncOperationLog(log);
+    if (!openOperationLog(log, fileName) || !describeOperationLog(log.fileName, log.bytes, header))
+        return false;
+    getFileVersion(fileName, header.dataBytes, header.dataModified);
+
+    string checkpointFileName = checkpointFileNameFor(fileName);
+    int fd = open(checkpointFileName.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd == -1)
+    {
+        cerr << "Error: Could not open file '" << checkpointFileName << "'.\n";
+        return false;
+    }
+
+    sCheckpointState &checkpoint = store.checkpoint;
+    bool allPages = checkpoint.allDirty;
+    bool ok = !allPages || invalidateCheckpointFile(fd);
+
+    // runs of consecutive changed pages go out with one pwrite each
+    size_t pageCount = (slotCount(store.clients) + checkpointPageRecords - 1) / checkpointPageRecords;
+    vector<sBinaryClientRecord> records;
+    for (size_t page = 0; ok && page < pageCount;)
+    {
+        auto changed = [&](size_t p)
+        { return allPages || (p < checkpoint.pageCapacity && checkpoint.dirtyPages[p].load(memory_order_relaxed)); };
+        if (!changed(page))
+        {
+            page++;
+            continue;
+        }
+
+        size_t firstPage = page;
+        while (page < pageCount && changed(page))
+            page++;
+
+        size_t firstSlot = firstPage * checkpointPageRecords;
+        size_t endSlot = min(slotCount(store.clients), page * checkpointPageRecords);
+        records.resize(endSlot - firstSlot);
+        for (size_t slot = firstSlot; ok && slot < endSlot; slot++)
+            ok = packSlotRecord(store.clients, slot, records[slot - firstSlot]);
+        if (!ok)
+        {
+            // a field too long for the record: keep no snapshot rather than a wrong one
+            invalidateCheckpointFile(fd);
+            break;
+        }
+        ok = pwriteAll(fd, records.data(), records.size() * sizeof(sBinaryClientRecord), checkpointRecordOffset(firstSlot));
+    }
+
+    memcpy(header.magic, checkpointFileMagic, sizeof(header.magic));
+    header.version = checkpointFileVersion;
+    header.recordSize = sizeof(sBinaryClientRecord);
+    header.recordCount = slotCount(store.clients);
+    ok = ok && syncFileData(fd) == 0 && pwriteAll(fd, &header, sizeof(header), 0) &&
+         ftruncate(fd, checkpointRecordOffset(header.recordCount)) == 0 && syncFileData(fd) == 0;
+    close(fd);
+
+    if (ok)
+        markAllSlotsCheckpointed(store);
+    return ok;
+}
+
+// Writes a checkpoint once enough changes are pending (and no rewrite of Clients.txt is outstanding,
+// since the snapshot records which Clients.txt it was taken over)
+inline void writeCheckpointIfDue(string fileName, sClientStore &store)
+{
+    sCheckpointState &checkpoint = store.checkpoint;
+    if (checkpoint.everyChanges == 0 || checkpoint.changes.load(memory_order_relaxed) < checkpoint.everyChanges)
+        return;
+
+    {
+        lock_guard<mutex> guard(store.fileFlusher.lock);
+        if (!store.fileFlusher.pendingFiles.empty() || store.fileFlusher.busy)
+            return;
+    }
+    writeCheckpoint(fileName, store);
+}
+
+// Maps the snapshot if it is still valid for Clients.txt and Clients.log; 'logBytes' is where replay starts
+inline bool mapValidCheckpoint(string fileName, sMappedFile &mapped, sCheckpointHeader &header)
+{
+    if (!mapFile(checkpointFileNameFor(fileName), mapped))
+        return false;
+
+    bool valid = mapped.size >= checkpointHeaderSize;
+    if (valid)
+    {
+        memcpy(&header, mapped.data, sizeof(header));
+        valid = memcmp(header.magic, checkpointFileMagic, sizeof(header.magic)) == 0 && header.version == checkpointFileVersion &&
+                header.recordSize == sizeof(sBinaryClientRecord) &&
+                mapped.size >= static_cast<size_t>(checkpointRecordOffset(header.recordCount));
+    }
+
+    uint64_t dataBytes;
+    int64_t dataModified;
+    getFileVersion(fileName, dataBytes, dataModified);
+    sCheckpointHeader current = {};
+    valid = valid && dataBytes == header.dataBytes && dataModified == header.dataModified &&
+            describeOperationLog(operationLogNameFor(fileName), header.logBytes, current) && current.logDevice == header.logDevice &&
+            current.logInode == header.logInode && current.logTailHash == header.logTailHash;
+
+    if (!valid)
+        unmapFile(mapped);
+    return valid;
+}
+
+// Copies the records of a mapped snapshot into 'slots' (slot for slot), split over 'threads' threads
+// that each fill slots of their own, appended in order at the end
+inline void readCheckpointRecords(const sMappedFile &mapped, uint64_t recordCount, sClientSlots &slots, int threads)
+{
+    size_t workers = (recordCount >= 100000) ? max(1, threads) : 1;
+    vector<sClientSlots> vParts(workers);
+    auto unpackRange = [&](size_t part)
+    {
+        size_t first = recordCount * part / workers, end = recordCount * (part + 1) / workers;
+        reserveClientSlots(vParts[part], end - first);
+        sBinaryClientRecord record;
+        for (size_t slot = first; slot < end; slot++)
+        {
+            memcpy(&record, mapped.data + checkpointRecordOffset(slot), sizeof(record));
+            appendBinaryRecord(vParts[part], record, sMoney{record.accountBalance});
+        }
+    };
+
+    vector<thread> vThreads;
+    for (size_t t = 1; t < workers; t++)
+        vThreads.emplace_back(unpackRange, t);
+    unpackRange(0);
+    for (thread &worker : vThreads)
+        worker.join();
+
+    slots = sClientSlots();
+    reserveClientSlots(slots, recordCount);
+    for (sClientSlots &part : vParts)
+        appendClientSlots(slots, part);
+}
+
+// The DELETE records in the first 'bytes' of a log: tombstones a snapshot already applied, while their rows
+// are still in the base file
+inline size_t countLogDeletes(const string &logFileName, const string &delim, uint64_t bytes)
+{
+    sMappedFile mapped;
+    if (!mapFile(logFileName, mapped))
+        return 0;
+
+    string prefix = logDelete + delim;
+    string_view contents(mapped.data, min<uint64_t>(bytes, mapped.size));
+    size_t deletes = 0;
+    size_t lineStart = 0, lineEnd;
+    while ((lineEnd = contents.find('\n', lineStart)) != string_view::npos)
+    {
+        if (contents.substr(lineStart, prefix.size()) == prefix)
+            deletes++;
+        lineStart = lineEnd + 1;
+    }
+    unmapFile(mapped);
+    return deletes;
+}
+
+// Loads the store from a valid snapshot plus the log written after it; false if there is no valid snapshot
+inline bool loadClientStoreFromCheckpoint(string fileName, string delim, sClientStore &store)
+{
+    sMappedFile mapped;
+    sCheckpointHeader header;
+    if (!mapValidCheckpoint(fileName, mapped, header))
+        return false;
+
+    readCheckpointRecords(mapped, header.recordCount, store.clients, store.loaderThreads);
+    unmapFile(mapped);
+
+    rebuildClientStoreIndexes(store);
+    markAllSlotsCheckpointed(store);
+    // the snapshot's deleted slots may already be purged from Clients.txt: only the log says which are not
+    store.tombstones.inFiles = countLogDeletes(operationLogNameFor(fileName), delim, header.logBytes);
+    store.watcher.logReplayedBytes = replayOperationLogFile(operationLogNameFor(fileName), delim, store, header.logBytes);
+    return true;
+}
+
+// At exit: once the pending rewrites are on disk, saves the pages changed since the last checkpoint
+inline void writeCheckpointAtExit(string fileName, sClientStore &store)
+{
+    if (!store.loaded || store.storageFormat != TextStorage || store.checkpoint.everyChanges == 0)
+        return;
+
+    waitForClientsFileRewrites(store.fileFlusher);
+    if (store.checkpoint.allDirty || store.checkpoint.changes.load() > 0)
+        writeCheckpoint(fileName, store);
+}
+
+// --checkpoint: loads the store and writes a complete checkpoint, then exits
+inline void runCheckpoint(string fileName, string delim, sClientStore &store)
+{
+    loadClientStore(fileName, delim, store);
+    if (store.storageFormat == BinaryStorage)
+    {
+        cout << "Checkpoints are for text storage; Clients.bin already loads without parsing.\n";
+        return;
+    }
+    if (store.storageFormat == ShardedStorage)
+    {
+        cout << "Checkpoints are for a single Clients.txt; shard files already load in parallel.\n";
+        return;
+    }
+
+    store.checkpoint.allDirty = true;
+    auto start = chrono::steady_clock::now();
+    bool written = writeCheckpoint(fileName, store);
+    chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+    if (written)
+        cout << slotCount(store.clients) << " slot(s) written to '" << checkpointFileNameFor(fileName) << "' in " << fixed
+             << setprecision(1) << elapsed.count() << " ms.\n";
+    else
+        cerr << "Error: Could not write the checkpoint.\n";
+}
+
+// *****************************************************************************************************************
+
+// ------------------------------------------------------ SHARDED STORAGE ------------------------------------------------------
+// *****************************************************************************************************************
+// Clients spread over N text files by a hash of the account number: "Clients.shard-03-of-08.txt" holds every
+// client whose account hashes to shard 3. Clients.shards (the manifest) names N; while it exists, the store is
+// sharded. The shards load in parallel, and a compaction only rewrites the shards whose clients changed, so an
+// update or a delete costs one shard rewrite instead of a rewrite of every client.
+// Clients.log stays a single file shared by all shards: a TRANSFER between two shards must stay one record,
+// and replaying in write order needs one sequence.
+
+// "Clients.txt", 3 of 8 -> "Clients.shard-03-of-08.txt"
+inline string shardFileNameFor(const string &fileName, size_t shard, size_t shardCount)
+{
+    char suffix[64];
+    snprintf(suffix, sizeof(suffix), ".shard-%02zu-of-%02zu.txt", shard, shardCount);
+    return replaceFileExtension(fileName, suffix);
+}
+
+// "Clients.txt" -> "Clients.shards"
+inline string shardManifestNameFor(const string &fileName)
+{
+    return replaceFileExtension(fileName, ".shards");
+}
+
+// Shard count named by the manifest, or 0 if there is no (valid) manifest
+inline size_t readShardManifest(const string &fileName)
+{
+    ifstream manifest(shardManifestNameFor(fileName));
+    size_t shardCount = 0;
+    if (!(manifest >> shardCount))
+        return 0;
+    return shardCount;
+}
+
+// Text storage is sharded whenever a manifest exists (after --reshard=N)
+inline void detectShardedStorage(const string &fileName, sClientStore &store)
+{
+    if (store.storageFormat == TextStorage && readShardManifest(fileName) > 0)
+        store.storageFormat = ShardedStorage;
+}
+
+inline void removeShardFiles(const string &fileName, size_t shardCount)
+{
+    for (size_t shard = 0; shard < shardCount; shard++)
+        unlink(shardFileNameFor(fileName, shard, shardCount).c_str());
+}
+
+// The contents of the shards flagged in 'wanted', keyed by shard file name
+inline vector<pair<string, string>> formatShardFiles(string fileName, string delim, const sClientStore &store, const vector<bool> &wanted)
+{
+    const sShardedStorage &shards = store.shards;
+    vector<string> contents(shards.shardCount);
+    for (size_t slot = 0; slot < slotCount(store.clients); slot++)
+    {
+        if (isSlotDeleted(store.clients, slot))
+            continue;
+        size_t shard = shardOfAccount(shards, slotAccountNumber(store.clients, slot));
+        if (!wanted[shard])
+            continue;
+        appendSlotAsLine(contents[shard], store.clients, slot, delim);
+        contents[shard] += '\n';
+    }
+
+    vector<pair<string, string>> files;
+    for (size_t shard = 0; shard < shards.shardCount; shard++)
+    {
+        if (wanted[shard])
+            files.push_back({shardFileNameFor(fileName, shard, shards.shardCount), move(contents[shard])});
+    }
+    return files;
+}
+
+// Parses every shard file, several at a time on up to loaderThreads threads (a shard gets the threads left
+// over when there are fewer shards than threads), and puts their clients in the store in shard order
+inline void readShardFiles(string fileName, string delim, sClientStore &store)
+{
+    size_t shardCount = store.shards.shardCount;
+    vector<sClientSlots> vShards(shardCount);
+    int threads = static_cast<int>(min<size_t>(store.loaderThreads, shardCount));
+    int threadsPerShard = max(1, store.loaderThreads / max(1, threads));
+
+    atomic<size_t> nextShard(0);
+    auto loadShards = [&]()
+    {
+        for (size_t shard; (shard = nextShard.fetch_add(1)) < shardCount;)
+            readClientsFromMappedFile(shardFileNameFor(fileName, shard, shardCount), delim, vShards[shard], threadsPerShard);
+    };
+    vector<thread> workers;
+    for (int i = 1; i < threads; i++)
+        workers.emplace_back(loadShards);
+    loadShards();
+    for (thread &worker : workers)
+        worker.join();
+
+    size_t total = 0;
+    for (const sClientSlots &vShard : vShards)
+        total += slotCount(vShard);
+
+    store.clients = sClientSlots();
+    reserveClientSlots(store.clients, total);
+    for (sClientSlots &vShard : vShards)
+        appendClientSlots(store.clients, vShard);
+}
+
+// --reshard=N: spreads the clients over N shard files (N = 0: back into a single Clients.txt), then exits.
+// The new files are written first and the manifest is switched last, so a crash leaves either the old layout
+// or the new one (with the log replayed on top of either); the log is emptied and the old files removed after.
+inline void runReshard(string fileName, string delim, sClientStore &store, size_t shardCount)
+{
+    loadClientStore(fileName, delim, store);
+    size_t oldShardCount = store.shards.shardCount;
+
+    auto start = chrono::steady_clock::now();
+    bool written = true;
+    if (shardCount == 0)
+        written = writeFileAtomically(fileName, formatClientsFileContents(store.clients, delim));
+    else
+    {
+        store.shards.shardCount = shardCount;
+        for (const auto &file : formatShardFiles(fileName, delim, store, vector<bool>(shardCount, true)))
+            written = written && writeFileAtomically(file.first, file.second);
+    }
+
+    string manifestName = shardManifestNameFor(fileName);
+    if (written && shardCount == 0)
+    {
+        written = (unlink(manifestName.c_str()) == 0 || errno == ENOENT);
+        fsyncParentDirectory(manifestName);
+    }
+    else if (written)
+        written = writeFileAtomically(manifestName, to_string(shardCount) + "\n");
+    if (!written)
+    {
+        cerr << "Error: Could not write the new layout; the old one is still in use.\n";
+        return;
+    }
+
+    // every record of the log is in the new files now
+    if (store.operationLog.fd != -1)
+    {
+        close(store.operationLog.fd);
+        store.operationLog.fd = -1;
+    }
+    writeFileAtomically(operationLogNameFor(fileName), "");
+    unlink(retiredLogNameFor(fileName).c_str());
+
+    if (oldShardCount != shardCount)
+        removeShardFiles(fileName, oldShardCount);
+    if (shardCount > 0)
+    {
+        unlink(fileName.c_str());
+        unlink(indexFileNameFor(fileName).c_str());
+        unlink(checkpointFileNameFor(fileName).c_str());
+    }
+    fsyncParentDirectory(fileName);
+    chrono::duration<double, milli> elapsed = chrono::steady_clock::now() - start;
+
+    size_t clients = store.columns.slotOfRow.size();
+    if (shardCount == 0)
+        cout << clients << " client(s) written to '" << fileName << "'";
+    else
+        cout << clients << " client(s) written to " << shardCount << " shard(s) '" << shardFileNameFor(fileName, 0, shardCount) << "' ...";
+    cout << " in " << fixed << setprecision(1) << elapsed.count() << " ms.\n";
+}
+
+// *****************************************************************************************************************
+
+inline sFileIdentity readFileIdentity(const string &fileName);
+inline sFileIdentity readStoreDataIdentity(const string &fileName, const sClientStore &store);
+inline void startStoreWatcher(string fileName, sClientStore &store, const sFileIdentity &data, const sFileIdentity &log, uint64_t logReplayedBytes);
+
+// Loads all clients into the store (from the newest checkpoint or Clients.txt or the shard files, plus the
+// replayed operation log, or from Clients.bin) and indexes them by account number
+inline void loadClientStore(string fileName, string delim, sClientStore &store)
+{
+    waitForClientsFileRewrites(store.fileFlusher); // the files on disk are then in one consistent state
+    store.loaded = true;
+    if (store.storageFormat == BinaryStorage)
+    {
+        string binaryFileName = binaryFileNameFor(fileName);
+        uint32_t version = binaryFileVersion;
+        if (readBinaryClientsFile(binaryFileName, store.clients, &version) && version != binaryFileVersion)
+        {
+            // balances are written in place as cents from now on, so a file of doubles is converted first
+            if (writeBinaryClientsFile(binaryFileName, store.clients) < 0)
+                cerr << "Error: Could not convert '" << binaryFileName << "' to version " << binaryFileVersion << ".\n";
+            readBinaryClientsFile(binaryFileName, store.clients, &version);
+        }
+        store.binaryStorage.recordCount = slotCount(store.clients);
+        rebuildClientStoreIndexes(store);
+        return;
+    }
+
+    sFileIdentity data = readStoreDataIdentity(fileName, store);
+    sFileIdentity log = readFileIdentity(operationLogNameFor(fileName));
+    if (store.storageFormat == ShardedStorage)
+    {
+        store.shards.shardCount = readShardManifest(fileName);
+        readShardFiles(fileName, delim, store);
+        rebuildClientStoreIndexes(store);
+        markAllShardsWritten(store); // the log records replayed next flag the shards they are not in yet
+        store.watcher.logReplayedBytes = replayOperationLog(fileName, delim, store);
+        store.tombstones.inFiles = store.tombstones.inMemory; // the base files hold no deleted rows of their own
+    }
+    else if (!loadClientStoreFromCheckpoint(fileName, delim, store)) // (which counts the tombstones itself)
+    {
+        readClientsFromMappedFile(fileName, delim, store.clients, store.loaderThreads);
+        rebuildClientStoreIndexes(store);
+        store.watcher.logReplayedBytes = replayOperationLog(fileName, delim, store);
+        store.tombstones.inFiles = store.tombstones.inMemory;
+    }
+    startStoreWatcher(fileName, store, data, log, store.watcher.logReplayedBytes);
+}
+
+// Loads the store the first time a screen needs every client; afterwards it stays resident and is kept
+// up to date by every add, update and delete
+inline void ensureClientStoreLoaded(string fileName, string delim, sClientStore &store)
+{
+    if (!store.loaded)
+        loadClientStore(fileName, delim, store);
+}
+
+// ------------------------------------------------------ STORE WATCHER ------------------------------------------------------
+// *****************************************************************************************************************
+// Keeps a loaded (text) store current while other processes write the same files. A watch on the directory of
+// Clients.txt (openDirectoryWatch) says whether anything happened; size, mtime and inode then say what:
+// - Clients.log grew (same inode): replay just the new records (our own records come back too; replaying
+//   them is harmless, every record is an absolute upsert)
+// - Clients.txt grew (an import appended): parse just the new lines and upsert them
+// - either one was replaced, shrank, or was rewritten in place: reload the store from scratch
+// With sharded storage the shard files are watched as one: any change to one of them reloads the store.
+// Without a directory watch the files are stat'ed on every check instead.
+
+inline sFileIdentity readFileIdentity(const string &fileName)
+{
+    sFileIdentity identity;
+    struct stat info;
+    if (stat(fileName.c_str(), &info) == -1)
+        return identity;
+
+    identity.exists = true;
+    identity.device = info.st_dev;
+    identity.inode = info.st_ino;
+    identity.bytes = info.st_size;
+    identity.modified = fileModifiedNanoseconds(info);
+    return identity;
+}
+
+// Clients.txt, or for sharded storage the manifest and every shard folded into one identity
+inline sFileIdentity readStoreDataIdentity(const string &fileName, const sClientStore &store)
+{
+    if (store.storageFormat != ShardedStorage)
+        return readFileIdentity(fileName);
+
+    sFileIdentity data = readFileIdentity(shardManifestNameFor(fileName));
+    size_t shardCount = readShardManifest(fileName);
+    data.inode = data.inode * 31 + shardCount;
+    for (size_t shard = 0; shard < shardCount; shard++)
+    {
+        sFileIdentity shardFile = readFileIdentity(shardFileNameFor(fileName, shard, shardCount));
+        data.inode = data.inode * 31 + shardFile.inode;
+        data.bytes += shardFile.bytes;
+        data.modified = max(data.modified, shardFile.modified);
+    }
+    return data;
+}
+
+inline bool isSameFile(const sFileIdentity &a, const sFileIdentity &b)
+{
+    return a.exists == b.exists && a.device == b.device && a.inode == b.inode;
+}
+
+inline string fileNameWithoutDirectory(const string &fileName)
+{
+    size_t slash = fileName.rfind('/');
+    return (slash == string::npos) ? fileName : fileName.substr(slash + 1);
+}
+
+inline string directoryOfFile(const string &fileName)
+{
+    size_t slash = fileName.rfind('/');
+    return (slash == string::npos) ? "." : fileName.substr(0, slash + 1);
+}
+
+inline sStoreWatcher::~sStoreWatcher()
+{
+    if (directoryWatchFd != -1)
+        close(directoryWatchFd);
+}
+
+// Remembers which versions of Clients.txt and Clients.log the freshly loaded store reflects
+// ('data' and 'log' are stat'ed before loading, so a write during the load is seen as a change)
+inline void startStoreWatcher(string fileName, sClientStore &store, const sFileIdentity &data, const sFileIdentity &log, uint64_t logReplayedBytes)
+{
+    sStoreWatcher &watcher = store.watcher;
+    watcher.data = data;
+    watcher.dataParsedBytes = data.bytes;
+    watcher.log = log;
+    watcher.logReplayedBytes = logReplayedBytes;
+    watcher.rebaseline = false;
+
+    if (watcher.directoryWatchFd == -1)
+        watcher.directoryWatchFd = openDirectoryWatch(directoryOfFile(fileName));
+}
+
+// Reads the pending directory watch events; true if one of them is about Clients.txt, Clients.log or a shard file
+inline bool drainStoreWatcherEvents(string fileName, sStoreWatcher &watcher)
+{
+    string dataName = fileNameWithoutDirectory(fileName);
+    string logName = fileNameWithoutDirectory(operationLogNameFor(fileName));
+    string shardPrefix = fileNameWithoutDirectory(replaceFileExtension(fileName, ".shard")); // shards and the manifest
+
+    bool relevant = false;
+    readDirectoryWatch(watcher.directoryWatchFd, [&](const string &name)
+                       { relevant = relevant || name.empty() || name == dataName || name == logName || name.rfind(shardPrefix, 0) == 0; });
+    return relevant;
+}
+
+// Parses the lines appended to Clients.txt since the last check and upserts them
+inline void applyClientsFileTail(string fileName, string delim, sClientStore &store, uint64_t endBytes)
+{
+    sStoreWatcher &watcher = store.watcher;
+    int fd = open(fileName.c_str(), O_RDONLY);
+    if (fd == -1)
+        return;
+
+    string tail(endBytes - watcher.dataParsedBytes, '\0');
+    ssize_t n = pread(fd, tail.data(), tail.size(), watcher.dataParsedBytes);
+    close(fd);
+
+    // only complete lines; a line still being written is picked up next time
+    size_t complete = (n > 0) ? tail.rfind('\n', n - 1) : string::npos;
+    if (complete == string::npos)
+        return;
+
+    sClientSlots appended;
+    parseClientLines(tail.data(), tail.data() + complete + 1, delim, appended);
+    for (size_t slot = 0; slot < slotCount(appended); slot++)
+    {
+        sClient client = clientAtSlot(appended, slot);
+        if (!updateClientInStore(store, client))
+            addClientToStore(store, client);
+    }
+    watcher.dataParsedBytes += complete + 1;
+}
+
+// Reloads everything; the log is reopened, since ours may be the one another process just retired
+inline void reloadClientStore(string fileName, string delim, sClientStore &store)
+{
+    if (store.operationLog.fd != -1)
+    {
+        syncOperationLog(store.operationLog);
+        close(store.operationLog.fd);
+        store.operationLog.fd = -1;
+    }
+    loadClientStore(fileName, delim, store);
+}
+
+// True if Clients.txt (or a shard) is no longer the version the store was parsed from, so only a reload helps
+inline bool isStoreDataReplaced(const sFileIdentity &data, const sClientStore &store)
+{
+    const sStoreWatcher &watcher = store.watcher;
+    return !isSameFile(data, watcher.data) || data.bytes < watcher.dataParsedBytes ||
+           (data.bytes == watcher.data.bytes && data.modified != watcher.data.modified) ||
+           (store.storageFormat == ShardedStorage && data.bytes != watcher.dataParsedBytes);
+}
+
+// Takes in what other processes appended to Clients.log and Clients.txt since the last check, without waiting
+// for the directory watch; compaction calls it (holding the flusher lock) right before it retires the log. Returns false
+// if a file was replaced instead, which only a reload can catch up with.
+inline bool catchUpOnStoreFiles(string fileName, string delim, sClientStore &store)
+{
+    sStoreWatcher &watcher = store.watcher;
+    if (!store.loaded || store.storageFormat == BinaryStorage)
+        return true;
+
+    sFileIdentity log = readFileIdentity(operationLogNameFor(fileName));
+    uint64_t replayFrom = 0; // after our own compaction the store has nothing of the new log yet
+    if (!watcher.rebaseline)
+    {
+        sFileIdentity data = readStoreDataIdentity(fileName, store);
+        bool rewriting = !store.fileFlusher.pendingFiles.empty() || store.fileFlusher.busy; // our own rewrite
+        if (!rewriting && isStoreDataReplaced(data, store))
+            return false;
+        if (!isSameFile(log, watcher.log) || log.bytes < watcher.logReplayedBytes)
+            return false;
+        if (!rewriting && data.bytes > watcher.dataParsedBytes)
+            applyClientsFileTail(fileName, delim, store, data.bytes);
+        replayFrom = watcher.logReplayedBytes;
+    }
+    if (log.bytes > replayFrom)
+        replayOperationLogFile(operationLogNameFor(fileName), delim, store, replayFrom);
+    return true;
+}
+
+// Brings a loaded text or sharded store up to date with what other processes wrote since the last check.
+// Cheap when nothing changed: one non-blocking read of the directory watch. The interactive session calls
+// it before every screen, batch mode and the server once per commit window.
+inline void refreshClientStore(string fileName, string delim, sClientStore &store)
+{
+    sStoreWatcher &watcher = store.watcher;
+    if (!store.loaded || store.storageFormat == BinaryStorage)
+        return;
+
+    if (watcher.directoryWatchFd == -1 || drainStoreWatcherEvents(fileName, watcher))
+        watcher.changed = true;
+    if (!watcher.changed && !watcher.rebaseline)
+        return;
+
+    {
+        // our own rewrite of Clients.txt is still on its way; look again once it is on disk
+        lock_guard<mutex> guard(store.fileFlusher.lock);
+        if (!store.fileFlusher.pendingFiles.empty() || store.fileFlusher.busy)
+            return;
+    }
+    watcher.changed = false;
+
+    sFileIdentity data = readStoreDataIdentity(fileName, store);
+    sFileIdentity log = readFileIdentity(operationLogNameFor(fileName));
+
+    if (watcher.rebaseline)
+    {
+        // our compaction wrote the store to a new Clients.txt and started a new log: only that log
+        // can hold anything the store does not have yet
+        watcher.data = data;
+        watcher.dataParsedBytes = data.bytes;
+        watcher.log = log;
+        watcher.logReplayedBytes = 0;
+        watcher.rebaseline = false;
+    }
+
+    bool dataReplaced = isStoreDataReplaced(data, store);
+    bool logReplaced = !isSameFile(log, watcher.log) || log.bytes < watcher.logReplayedBytes;
+    if (dataReplaced || logReplaced)
+    {
+        reloadClientStore(fileName, delim, store);
+        return;
+    }
+
+    if (data.bytes > watcher.dataParsedBytes)
+        applyClientsFileTail(fileName, delim, store, data.bytes);
+    watcher.data = data;
+
+    if (log.bytes > watcher.logReplayedBytes)
+        watcher.logReplayedBytes = replayOperationLogFile(operationLogNameFor(fileName), delim, store, watcher.logReplayedBytes);
+    watcher.log = log;
+}
+
+// *****************************************************************************************************************
+
+// Syncs the binary file after a write when every operation must be durable
+inline void syncBinaryStorageIfNeeded(sClientStore &store)
+{
+    if (store.operationLog.fsyncPolicy == FsyncEveryOp)
+        syncFileData(store.binaryStorage.fd);
+}
+
+// Persists clients that were already added to the store during this session. Returns false if one could not
+// be saved; that client and the ones after it are taken back out of the store.
+inline bool saveNewClients(string fileName, string delim, vector<sClient> &vNewClients, sClientStore &store)
+{
+    size_t saved = 0;
+    if (store.storageFormat == BinaryStorage)
+    {
+        if (openBinaryStorage(store.binaryStorage, fileName))
+        {
+            while (saved < vNewClients.size() &&
+                   writeBinaryRecord(store.binaryStorage, findClientSlot(store, vNewClients[saved].accountNumber), vNewClients[saved]))
+                saved++;
+            syncBinaryStorageIfNeeded(store);
+        }
+    }
+    else
+    {
+        while (saved < vNewClients.size() && logClientAdded(fileName, delim, vNewClients[saved], store))
+            saved++;
+        updateClientIndexFileIfOpen(fileName, delim, store);
+        compactOperationLogIfNeeded(fileName, delim, store);
+    }
+
+    for (size_t i = saved; i < vNewClients.size(); i++)
+        discardUnsavedClient(store, vNewClients[i].accountNumber);
+    return saved == vNewClients.size();
+}
+
+// Applies an update to the store and persists it; returns false if the account does not exist
+inline bool updateClientRecord(string fileName, string delim, const sClient &client, sClientStore &store)
+{
+    if (!store.loaded && store.storageFormat == TextStorage && openClientIndexFile(fileName, delim, store))
+        return updateClientThroughIndexFile(fileName, delim, client, store);
+    ensureClientStoreLoaded(fileName, delim, store);
+
+    int slot = findClientSlot(store, client.accountNumber);
+    if (slot == -1)
+        return false;
+
+    if (store.storageFormat == BinaryStorage)
+    {
+        if (!openBinaryStorage(store.binaryStorage, fileName))
+            return false;
+
+        // a balance-only change rewrites just the 8 balance bytes of the record
+        const sCompactClient &oldRecord = store.clients.records[slot];
+        bool balanceOnly = compactPinCode(oldRecord) == client.pinCode && compactFullName(oldRecord) == client.fullName &&
+                           compactPhone(oldRecord) == client.phone;
+        bool written = balanceOnly ? writeBinaryBalance(store.binaryStorage, slot, client.accountBalance)
+                                   : writeBinaryRecord(store.binaryStorage, slot, client);
+        if (!written)
+            return false;
+
+        updateClientInStore(store, client);
+        syncBinaryStorageIfNeeded(store);
+        return true;
+    }
+
+    updateClientInStore(store, client);
+    logClientUpdated(fileName, delim, client, store);
+    updateClientIndexFileIfOpen(fileName, delim, store);
+    compactOperationLogIfNeeded(fileName, delim, store);
+    return true;
+}
+
+// Deletes a client from the store and persists it; returns false if the account does not exist
+inline bool deleteClientByAccNum(string fileName, string delim, string accountNumber, sClientStore &store)
+{
+    if (!store.loaded && store.storageFormat == TextStorage && openClientIndexFile(fileName, delim, store))
+        return deleteClientThroughIndexFile(fileName, delim, accountNumber, store);
+    ensureClientStoreLoaded(fileName, delim, store);
+
+    int slot = findClientSlot(store, accountNumber);
+    if (slot == -1)
+        return false;
+
+    if (store.storageFormat == BinaryStorage)
+    {
+        if (!openBinaryStorage(store.binaryStorage, fileName) || !writeBinaryTombstone(store.binaryStorage, slot))
+            return false;
+
+        markClientAsDeletedInStore(store, accountNumber);
+        syncBinaryStorageIfNeeded(store);
+        return true;
+    }
+
+    markClientAsDeletedInStore(store, accountNumber);
+    logClientDeleted(fileName, delim, accountNumber, store);
+    updateClientIndexFileIfOpen(fileName, delim, store);
+    compactOperationLogIfNeeded(fileName, delim, store);
+    return true;
+}
+
+// ------------------------------------------------------ CLIENT LOOKUPS ------------------------------------------------------
+// *****************************************************************************************************************
+
+// Searches the file for a client by account number and returns it through 'foundClient'.
+// Returns true if found, false otherwise.
+inline bool findClientInFileByAccountNum(string fileName, string delim, string accountNumber, sClientStore &store, sClient &foundClient)
+{
+
+    if (!store.loaded)
+    {
+        // Text storage answers from an up-to-date Clients.idx: a few index pages plus one record, nothing else
+        // is loaded. A stale index is not fixed here, a lookup neither writes nor waits: the store is loaded.
+        if (store.storageFormat == TextStorage && openCurrentClientIndexFile(fileName, store))
+            return findClientThroughIndexFile(fileName, delim, accountNumber, store, foundClient);
+
+        // Load all clients from the file into the store
+        loadClientStore(fileName, delim, store);
+    };
+
+    // Look the account number up in the index
+    int slot = findClientSlot(store, accountNumber);
+    if (slot == -1)
+        return false;
+
+    foundClient = clientAtSlot(store.clients, slot); // Output the found client
+    return true;
+}
+
+inline bool markClientAsDeletedByAccNum(string accountNumber, sClientStore &store)
+{
+    return markClientAsDeletedInStore(store, accountNumber);
+}
+
+// removing a client from the store without affecting the file .
+inline void removeClientFromVector(sClientStore &store, string accountNumber)
+{
+    markClientAsDeletedInStore(store, accountNumber);
+}
+
+// *****************************************************************************************************************
+
+#endif
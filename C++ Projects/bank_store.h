@@ -0,0 +1,281 @@
+#ifndef BANK_STORE_H
+#define BANK_STORE_H
+
+/*
+=======================================
+Bank client store — everything a loaded clients file keeps in memory
+=======================================
+
+sClientStore holds the client slots and all that is derived from them or attached to them: the account index,
+the columnar copy of the balances, the prefix and name search indexes, the open log, binary file and index file,
+the background file flusher, the checkpoint state and the watcher that follows other processes' writes.
+This header only declares the structures; bank_indexes.h and bank_storage.h work on them.
+*/
+
+#include "bank_records.h"
+
+// ------------------------------------------------------ CLIENT STORE ------------------------------------------------------
+// ********************************************************************************************************************************
+
+// Open-addressing hash index (linear probing) from account number to the client's slot.
+// Slots never move once assigned: deleted clients stay in their slot marked for delete until the
+// store is compacted, so the index only has to be rebuilt when the slots themselves are renumbered.
+const int emptyIndexEntry = -1;
+const int deletedIndexEntry = -2;
+
+struct sAccountIndex
+{
+    vector<int> entries; // slot, emptyIndexEntry or deletedIndexEntry
+    size_t used = 0;     // live entries + deleted markers (drives the resize)
+    size_t live = 0;     // live entries only
+};
+
+// How often the operation log is forced to disk (latency vs durability)
+enum enFsyncPolicy
+{
+    FsyncEveryOp = 1, // fsync after every logged operation (no acknowledged op is ever lost)
+    FsyncGroupCommit, // fsync once per group of operations or once the commit window has passed
+    FsyncNone,        // leave flushing to the OS (fastest, recent ops may be lost on power failure)
+};
+
+// Dense rows of the live clients, kept next to the slots for scans and reports.
+// Balances (in cents) are contiguous without the deleted slots' gaps, so aggregate reports only stream
+// 8 bytes per live client through the cache. Rows are dense (deleting swaps the last row into the hole),
+// so row order is not slot order.
+struct sClientColumns
+{
+    vector<long long> balances; // hot column, cents
+    vector<int> slotOfRow;      // row -> slot
+    vector<int> rowOfSlot;      // slot -> row, -1 for deleted clients
+};
+
+// Field a prefix index is built on
+enum enPrefixField
+{
+    PrefixPhone = 1,
+    PrefixAccountNumber,
+};
+
+// Entries added since the last merge before they are merged into the sorted array
+const size_t prefixIndexMergeThreshold = 4096;
+
+// Secondary index answering "first K clients whose field starts with ..." in O(log n + K).
+// A sorted array of (key, slot) plus a short unsorted list of recent additions that is merged in
+// once it reaches prefixIndexMergeThreshold. Entries are never edited: a deleted client or a changed
+// field just leaves an entry whose key no longer matches its client, which queries skip and merges drop.
+struct sPrefixIndex
+{
+    enPrefixField field = PrefixPhone;
+    size_t keyWidth = 0;    // bytes per key, zero-padded
+    vector<char> keys;      // sorted keys, keyWidth bytes each
+    vector<int> slots;      // slot of each sorted key
+    vector<char> recentKeys; // unsorted, since the last merge
+    vector<int> recentSlots;
+    size_t staleEntries = 0; // entries that stopped being current since the last merge (approximate)
+};
+
+// Slots of the clients whose name contains one trigram: ascending slots stored as varint-encoded gaps
+// (1-2 bytes per client instead of 4). Slots that arrive out of order (renamed clients) are kept aside.
+// Slots taken out (renamed or deleted clients) are listed in 'removed' and skipped, until there are
+// enough of them to re-encode the list without them.
+struct sPostingList
+{
+    vector<uint8_t> bytes;
+    int lastSlot = -1;
+    uint32_t count = 0; // slots in the list, not counting the removed ones
+    vector<int> unsorted;
+    vector<int> removed; // sorted
+};
+
+// Inverted index from name trigram to posting list, for typo-tolerant name search. A renamed client
+// leaves the lists of the trigrams it lost, a deleted one leaves all of its lists.
+struct sNameIndex
+{
+    unordered_map<uint32_t, sPostingList> postings;
+    mutable vector<uint16_t> sharedCounts; // findByName's per-slot counters, all 0 between queries (one search at a time)
+};
+
+struct sNameMatch
+{
+    int slot;
+    int distance; // edits between the query and the closest part of the name
+};
+
+// Where the clients are persisted
+enum enStorageFormat
+{
+    TextStorage = 1, // Clients.txt + Clients.log
+    BinaryStorage,   // Clients.bin, fixed-width records updated in place
+    ShardedStorage,  // Clients.shard-KK-of-NN.txt files chosen by account number hash + Clients.log
+};
+
+// Open handle on the binary clients file
+struct sBinaryStorage
+{
+    string fileName;
+    int fd = -1;
+    uint64_t recordCount = 0; // records in the file, live and deleted (= slots in the store)
+};
+
+// Shard files of sharded storage (see SHARDED STORAGE). Shards are flagged by concurrent transactions too,
+// so each flag is an atomic of its own.
+struct sShardedStorage
+{
+    size_t shardCount = 0;                  // from Clients.shards; 0 until sharded storage is loaded
+    unique_ptr<atomic<bool>[]> dirtyShards; // shard -> changed since its file was last written
+};
+
+// Open handle on Clients.idx, the on-disk B+tree from account number to client line (text storage)
+struct sIndexFile
+{
+    string fileName;
+    int fd = -1;
+    uint32_t rootPage = 0;
+    uint32_t pageCount = 0;
+    uint64_t entryCount = 0;
+    uint64_t dataBytes = 0;   // size of the Clients.txt the tree was built from
+    int64_t dataModified = 0; // and its modification time in ns
+    uint64_t logBytes = 0;    // how much of Clients.log the tree already covers
+    bool changing = false;    // this process set the header's 'changing' flag (pages are changed in place)
+    ~sIndexFile();            // clears the flag once every page is on disk
+};
+
+// Append-only log of ADD / UPDATE / DELETE records kept next to the clients file
+struct sOperationLog
+{
+    string fileName;                                // empty until the log is opened
+    int fd = -1;                                    // opened in append mode
+    enFsyncPolicy fsyncPolicy = FsyncGroupCommit;   // see enFsyncPolicy
+    size_t groupCommitSize = 64;                    // operations per fsync in group commit mode
+    int groupCommitWindowMs = 10;                   // max age of an unsynced operation in group commit mode
+    size_t compactionThreshold = 1024 * 1024;       // log size in bytes that triggers a compaction
+    size_t bytes = 0;                               // current size of the log file
+    size_t pendingOps = 0;                          // operations written but not fsync'ed yet
+    chrono::steady_clock::time_point oldestPending; // when the first pending operation was written
+};
+
+// One queued rewrite: the new contents, or (a compaction) the file merged with the records of the retired log
+struct sFileRewrite
+{
+    string contents;
+    bool mergeRetiredLog = false;
+    string delim;
+    size_t shard = 0;      // merge only the records of this shard
+    size_t shardCount = 0; // (0: not sharded, every record)
+};
+
+// Background thread that performs the full rewrites of Clients.txt or of the shard files (see ATOMIC FILE REWRITES)
+// and, as the background compactor, folds the retired log into them (see BACKGROUND COMPACTION)
+struct sClientsFileFlusher
+{
+    mutex lock;
+    condition_variable changed;
+    thread worker;                          // started by the first rewrite
+    map<string, sFileRewrite> pendingFiles; // file -> newest rewrite not written yet
+    map<string, sFileRewrite> failedFiles;  // file -> rewrite that failed, retried with the next rewrite
+    string retiredLogName;                  // retired log the pending rewrites cover (empty: none)
+    string indexRebuildFileName;            // clients file whose Clients.idx is rebuilt once the retired log is released
+    string indexRebuildDelim;
+    bool busy = false;                      // a rewrite (or the index rebuild) is being written
+    bool stopping = false;
+    size_t requested = 0; // rewrites asked for
+    size_t coalesced = 0; // rewrites replaced by a newer one before they started
+    size_t written = 0;   // rewrites that reached the disk
+    size_t bytesPerSecond = 64 * 1024 * 1024; // read + write budget of a compaction (0 = unlimited)
+    size_t compactions = 0;                   // compaction rewrites that reached the disk
+    size_t tombstonesPurged = 0;              // deleted rows they dropped from the files
+    uint64_t bytesReclaimed = 0;              // and the bytes of those rows
+    double lastCompactionSeconds = 0;         // duration of the newest one
+
+    ~sClientsFileFlusher(); // writes what is pending before the program ends
+};
+
+// Which pages of the checkpoint file (checkpointPageRecords slots each) changed since the last checkpoint.
+// Pages are flagged by concurrent transactions too, so each flag is an atomic of its own.
+const size_t checkpointPageRecords = 32;
+
+struct sCheckpointState
+{
+    unique_ptr<atomic<bool>[]> dirtyPages; // page -> changed since the last checkpoint
+    size_t pageCapacity = 0;
+    bool allDirty = true;         // slots were renumbered (or never written): the next checkpoint writes every page
+    atomic<size_t> changes{0};    // slot changes since the last checkpoint
+    size_t everyChanges = 100000; // write a checkpoint once this many changes are pending (0 = never)
+};
+
+// Which version of a file the store reflects (see STORE WATCHER)
+struct sFileIdentity
+{
+    bool exists = false;
+    uint64_t device = 0;
+    uint64_t inode = 0;
+    uint64_t bytes = 0;
+    int64_t modified = 0; // ns
+};
+
+struct sStoreWatcher
+{
+    int directoryWatchFd = -1;     // watches the directory of Clients.txt; -1: stat on every check
+    bool changed = false;          // an event arrived that was not handled yet
+    bool rebaseline = false;       // our own compaction replaced Clients.txt and the log
+    sFileIdentity data;            // Clients.txt as of the last check
+    uint64_t dataParsedBytes = 0;  // bytes of Clients.txt in the store
+    sFileIdentity log;             // Clients.log as of the last check
+    uint64_t logReplayedBytes = 0; // bytes of Clients.log in the store
+    ~sStoreWatcher();
+};
+
+// Layout of Clients.ckpt (see CHECKPOINTS)
+const char checkpointFileMagic[8] = {'B', 'A', 'N', 'K', 'C', 'K', 'P', 'T'};
+const uint32_t checkpointFileVersion = 2; // version 1 stored balances as doubles and is ignored (rebuilt from the text files)
+const size_t checkpointHeaderSize = 4096;
+const size_t checkpointLogTailBytes = 4096; // log bytes hashed to recognise the log the snapshot reaches into
+
+struct sCheckpointHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+    uint64_t recordCount;  // slots in the snapshot
+    uint64_t dataBytes;    // Clients.txt the snapshot was taken over
+    int64_t dataModified;  // (nanoseconds)
+    uint64_t logDevice;    // Clients.log at that time
+    uint64_t logInode;
+    uint64_t logBytes;     // log bytes already contained in the snapshot
+    uint64_t logTailHash;  // FNV-1a of the last checkpointLogTailBytes before logBytes
+};
+
+// Deleted clients not purged yet (see BACKGROUND COMPACTION)
+struct sTombstones
+{
+    size_t inFiles = 0;             // deletes not folded into Clients.txt / the shards yet (DELETE records in the logs)
+    size_t inMemory = 0;            // deleted slots still held in the store
+    double compactionRatio = 0.25;  // tombstones / rows at which they are purged
+    size_t memoryPurges = 0;        // times the deleted slots were dropped from the store
+    double lastMemoryPurgeSeconds = 0;
+};
+
+// The in-memory client store: the client records plus the index that keeps lookups O(1)
+struct sClientStore
+{
+    sClientSlots clients;
+    sAccountIndex accountIndex;
+    sClientColumns columns;
+    sPrefixIndex phoneIndex;
+    sPrefixIndex accountPrefixIndex;
+    sNameIndex nameIndex;
+    sOperationLog operationLog;
+    sClientsFileFlusher fileFlusher;
+    sCheckpointState checkpoint;
+    sTombstones tombstones;
+    sStoreWatcher watcher;
+    enStorageFormat storageFormat = TextStorage;
+    sBinaryStorage binaryStorage;
+    sShardedStorage shards;
+    sIndexFile indexFile;
+    bool loaded = false; // false until loadClientStore ran; text storage then answers FIND / UPDATE / DELETE from Clients.idx
+    int loaderThreads = max(1u, thread::hardware_concurrency()); // worker threads used to parse Clients.txt
+    size_t listingPageRows = 20;                                  // rows per page of Show Clients on a terminal
+};
+
+#endif
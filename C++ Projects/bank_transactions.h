@@ -0,0 +1,395 @@
+#ifndef BANK_TRANSACTIONS_H
+#define BANK_TRANSACTIONS_H
+
+/*
+=======================================
+Bank transactions — deposits, withdrawals and transfers
+=======================================
+
+- Transactions are checked and applied in memory, then persisted as one log record each (a transfer is a
+  single TRANSFER record) or as balance pwrites in binary storage; batches share one write and one fsync.
+- Concurrent accounts: many threads change balances at once under striped per-account locks; a transfer
+  locks its two stripes in a fixed order so two transfers can never deadlock.
+*/
+
+#include "bank_storage.h"
+
+// ------------------------------------------------------ TRANSACTIONS ------------------------------------------------------
+// *****************************************************************************************************************
+// Deposit, withdraw and two-account transfer on top of the client store.
+// A transaction is checked and applied in memory first, then persisted: in text storage as one log record
+// per transaction (a transfer is a single TRANSFER record, so a crash can never keep only one side of it);
+// in binary storage as 8-byte balance pwrites. Batches are persisted with one write and one fsync.
+
+enum enTransactionType
+{
+    Deposit = 1,
+    Withdraw,
+    Transfer,
+};
+
+enum enTransactionResult
+{
+    TransactionDone = 1,
+    TransactionAccountNotFound,
+    TransactionInsufficientFunds,
+    TransactionInvalidAmount,
+    TransactionSameAccount,
+    TransactionNotSaved, // checked and applied, but it could not be persisted, so it was rolled back
+    TransactionBalanceTooLarge,
+};
+
+struct sTransaction
+{
+    enTransactionType type;
+    string accountNumber;   // account to deposit to / withdraw from / transfer from
+    string toAccountNumber; // transfers only
+    sMoney amount;
+};
+
+struct sBatchResult
+{
+    size_t done = 0;
+    size_t rejected = 0;
+    bool saved = true; // false: persisting failed and every transaction of the batch was rolled back
+    double seconds = 0;
+};
+
+inline string transactionResultMessage(enTransactionResult result)
+{
+    switch (result)
+    {
+    case TransactionDone:
+        return "Transaction completed successfully.";
+    case TransactionAccountNotFound:
+        return "Account not found.";
+    case TransactionInsufficientFunds:
+        return "Insufficient funds.";
+    case TransactionInvalidAmount:
+        return "Amount must be at least 0.01.";
+    case TransactionSameAccount:
+        return "Cannot transfer to the same account.";
+    case TransactionNotSaved:
+        return "The transaction could not be saved and was cancelled.";
+    case TransactionBalanceTooLarge:
+        return "The balance would exceed the largest amount an account can hold.";
+    default:
+        return "Unknown result.";
+    }
+}
+
+// True if crediting 'amount' would take 'balance' past maxBalanceCents (and past what the files can hold)
+inline bool isCreditTooLarge(sMoney balance, sMoney amount)
+{
+    return balance.cents > maxBalanceCents - amount.cents;
+}
+
+// Checks a transaction between already looked-up slots (-1 = not found) and applies it (memory only).
+// The slots whose balance changed are returned through 'changedSlots'.
+inline enTransactionResult applyTransactionToSlots(sClientStore &store, enTransactionType type, int fromSlot, int toSlot, sMoney amount,
+                                            vector<int> &changedSlots)
+{
+    changedSlots.clear();
+    if (!(amount > sMoney{}))
+        return TransactionInvalidAmount;
+    if (fromSlot == -1)
+        return TransactionAccountNotFound;
+
+    sMoney &fromBalance = store.clients.balances[fromSlot];
+    sClientColumns &columns = store.columns;
+
+    if (type == Deposit)
+    {
+        if (isCreditTooLarge(fromBalance, amount))
+            return TransactionBalanceTooLarge;
+        fromBalance += amount;
+        columns.balances[columns.rowOfSlot[fromSlot]] = fromBalance.cents;
+        changedSlots.push_back(fromSlot);
+        markSlotChanged(store, fromSlot);
+        return TransactionDone;
+    }
+
+    if (fromBalance < amount)
+        return TransactionInsufficientFunds;
+
+    if (type == Withdraw)
+    {
+        fromBalance -= amount;
+        columns.balances[columns.rowOfSlot[fromSlot]] = fromBalance.cents;
+        changedSlots.push_back(fromSlot);
+        markSlotChanged(store, fromSlot);
+        return TransactionDone;
+    }
+
+    if (toSlot == -1)
+        return TransactionAccountNotFound;
+    if (toSlot == fromSlot)
+        return TransactionSameAccount;
+
+    sMoney &toBalance = store.clients.balances[toSlot];
+    if (isCreditTooLarge(toBalance, amount))
+        return TransactionBalanceTooLarge;
+    fromBalance -= amount;
+    toBalance += amount;
+    columns.balances[columns.rowOfSlot[fromSlot]] = fromBalance.cents;
+    columns.balances[columns.rowOfSlot[toSlot]] = toBalance.cents;
+    changedSlots.push_back(fromSlot);
+    changedSlots.push_back(toSlot);
+    markSlotChanged(store, fromSlot);
+    markSlotChanged(store, toSlot);
+    return TransactionDone;
+}
+
+// Looks up the accounts of the transaction, then checks and applies it (memory only)
+inline enTransactionResult applyTransactionToStore(sClientStore &store, const sTransaction &transaction, vector<int> &changedSlots)
+{
+    int fromSlot = findClientSlot(store, transaction.accountNumber);
+    int toSlot = (transaction.type == Transfer) ? findClientSlot(store, transaction.toAccountNumber) : -1;
+    return applyTransactionToSlots(store, transaction.type, fromSlot, toSlot, transaction.amount, changedSlots);
+}
+
+// Undoes a transaction that applyTransactionToSlots applied to 'changedSlots' (memory only)
+inline void revertTransactionOnSlots(sClientStore &store, enTransactionType type, const vector<int> &changedSlots, sMoney amount)
+{
+    sClientColumns &columns = store.columns;
+    for (size_t i = 0; i < changedSlots.size(); i++)
+    {
+        // the first slot is the one money was taken from, except for a deposit
+        int slot = changedSlots[i];
+        sMoney &balance = store.clients.balances[slot];
+        if (type == Deposit || i == 1)
+            balance -= amount;
+        else
+            balance += amount;
+        columns.balances[columns.rowOfSlot[slot]] = balance.cents;
+        markSlotChanged(store, slot);
+    }
+}
+
+// The log record describing the new state of the changed clients
+inline string formatTransactionLogRecord(const sClientStore &store, const vector<int> &changedSlots, string delim)
+{
+    if (changedSlots.size() == 2)
+        return logTransfer + delim + formatSlotAsLine(store.clients, changedSlots[0], delim) + delim +
+               formatSlotAsLine(store.clients, changedSlots[1], delim);
+    return logUpdate + delim + formatSlotAsLine(store.clients, changedSlots[0], delim);
+}
+
+// Persists the balances of the changed slots; one fsync at the end (as the fsync policy allows)
+inline bool persistTransactionBalances(string fileName, string delim, sClientStore &store, const vector<string> &logRecords,
+                                const vector<int> &changedSlots)
+{
+    if (store.storageFormat == BinaryStorage)
+    {
+        if (!openBinaryStorage(store.binaryStorage, fileName))
+            return false;
+        for (int slot : changedSlots)
+        {
+            if (!writeBinaryBalance(store.binaryStorage, slot, store.clients.balances[slot]))
+                return false;
+        }
+        if (store.operationLog.fsyncPolicy != FsyncNone)
+            syncFileData(store.binaryStorage.fd);
+        return true;
+    }
+
+    bool written = appendBatchToOperationLog(store.operationLog, fileName, logRecords);
+    compactOperationLogIfNeeded(fileName, delim, store);
+    return written;
+}
+
+// Executes and persists one transaction
+inline enTransactionResult executeTransaction(string fileName, string delim, sClientStore &store, const sTransaction &transaction)
+{
+    vector<int> changedSlots;
+    enTransactionResult result = applyTransactionToStore(store, transaction, changedSlots);
+    if (result != TransactionDone)
+        return result;
+
+    if (!persistTransactionBalances(fileName, delim, store, {formatTransactionLogRecord(store, changedSlots, delim)}, changedSlots))
+    {
+        revertTransactionOnSlots(store, transaction.type, changedSlots, transaction.amount);
+        return TransactionNotSaved;
+    }
+    return TransactionDone;
+}
+
+// Executes a batch of transactions in order (each one checked on its own, failed ones are skipped)
+// and persists all of them with one group commit; if that fails, the whole batch is rolled back
+inline sBatchResult executeTransactionBatch(string fileName, string delim, sClientStore &store, const vector<sTransaction> &vTransactions)
+{
+    sBatchResult result;
+    auto start = chrono::steady_clock::now();
+
+    vector<string> logRecords;
+    vector<int> changedSlots, allChangedSlots;
+    vector<size_t> appliedEnds; // end of each applied transaction's slots in allChangedSlots
+    vector<const sTransaction *> applied;
+    bool logged = (store.storageFormat != BinaryStorage);
+    if (logged)
+        logRecords.reserve(vTransactions.size());
+
+    for (const sTransaction &transaction : vTransactions)
+    {
+        if (applyTransactionToStore(store, transaction, changedSlots) != TransactionDone)
+        {
+            result.rejected++;
+            continue;
+        }
+        result.done++;
+        if (logged)
+            logRecords.push_back(formatTransactionLogRecord(store, changedSlots, delim));
+        allChangedSlots.insert(allChangedSlots.end(), changedSlots.begin(), changedSlots.end());
+        appliedEnds.push_back(allChangedSlots.size());
+        applied.push_back(&transaction);
+    }
+
+    // binary storage only needs each changed balance written once
+    vector<int> writtenSlots = allChangedSlots;
+    sort(writtenSlots.begin(), writtenSlots.end());
+    writtenSlots.erase(unique(writtenSlots.begin(), writtenSlots.end()), writtenSlots.end());
+
+    if (!persistTransactionBalances(fileName, delim, store, logRecords, writtenSlots))
+    {
+        // newest first, so every balance goes back through the values it had
+        for (size_t i = applied.size(); i-- > 0;)
+        {
+            size_t begin = (i == 0) ? 0 : appliedEnds[i - 1];
+            vector<int> slots(allChangedSlots.begin() + begin, allChangedSlots.begin() + appliedEnds[i]);
+            revertTransactionOnSlots(store, applied[i]->type, slots, applied[i]->amount);
+        }
+        result.saved = false;
+        result.rejected += result.done;
+        result.done = 0;
+    }
+
+    result.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+// *****************************************************************************************************************
+
+// ------------------------------------------------------ CONCURRENT ACCOUNTS ------------------------------------------------------
+// *****************************************************************************************************************
+// Lets many threads change balances at the same time. While they do, the shape of the store (clients, index,
+// columns) must not change - callers hold the store lock shared - so account lookups need no lock at all.
+// Each slot's balance is guarded by one of a fixed set of stripe locks (slot % stripe count), so transactions
+// on different accounts rarely wait for each other. A transfer locks its two stripes lowest first: two
+// transfers in opposite directions always lock in the same order and can never deadlock.
+
+const size_t defaultAccountStripes = 1024;
+
+struct alignas(64) sAccountStripe // one cache line each, so neighbouring stripes do not share one
+{
+    mutex lock;
+};
+
+struct sConcurrentAccounts
+{
+    sClientStore *store = nullptr;
+    vector<sAccountStripe> stripes;
+    mutex logLock; // log records are appended in the order the balances changed
+};
+
+inline void initConcurrentAccounts(sConcurrentAccounts &accounts, sClientStore &store, size_t stripeCount)
+{
+    accounts.store = &store;
+    accounts.stripes = vector<sAccountStripe>(max<size_t>(1, stripeCount));
+}
+
+// Locks the stripes of both slots (-1 = none), lowest stripe first and each stripe only once
+inline void lockAccountStripes(sConcurrentAccounts &accounts, int slotA, int slotB, unique_lock<mutex> &first, unique_lock<mutex> &second)
+{
+    size_t stripeCount = accounts.stripes.size();
+    size_t a = (slotA == -1) ? slotB % stripeCount : slotA % stripeCount;
+    size_t b = (slotB == -1) ? a : slotB % stripeCount;
+    if (a > b)
+        swap(a, b);
+
+    first = unique_lock<mutex>(accounts.stripes[a].lock);
+    if (b != a)
+        second = unique_lock<mutex>(accounts.stripes[b].lock);
+}
+
+// Persists one concurrent transaction; called while its stripes are still locked,
+// so a later change to the same account cannot reach the disk first. Returns false if a write failed.
+inline bool persistConcurrentTransaction(string fileName, string delim, sConcurrentAccounts &accounts, const vector<int> &changedSlots)
+{
+    sClientStore &store = *accounts.store;
+    if (store.storageFormat == BinaryStorage)
+    {
+        {
+            lock_guard<mutex> logGuard(accounts.logLock); // the first transaction opens the file for all threads
+            if (!openBinaryStorage(store.binaryStorage, fileName))
+                return false;
+        }
+        // positional 8-byte writes to different records do not interfere
+        for (int slot : changedSlots)
+        {
+            if (!writeBinaryBalance(store.binaryStorage, slot, store.clients.balances[slot]))
+                return false;
+        }
+        if (store.operationLog.fsyncPolicy == FsyncEveryOp && syncFileData(store.binaryStorage.fd) != 0)
+            return false;
+        return true;
+    }
+
+    string record = formatTransactionLogRecord(store, changedSlots, delim);
+    lock_guard<mutex> logGuard(accounts.logLock);
+    return appendToOperationLog(store.operationLog, fileName, record);
+}
+
+// True once money commands grew the log past its compaction threshold. They run under the shared store
+// lock, so the caller takes the lock exclusively and runs compactOperationLogIfNeeded itself.
+inline bool isConcurrentLogCompactionDue(sConcurrentAccounts &accounts)
+{
+    const sOperationLog &log = accounts.store->operationLog;
+    lock_guard<mutex> logGuard(accounts.logLock);
+    return log.bytes >= log.compactionThreshold;
+}
+
+// Applies a transaction between already looked-up slots while other threads do the same.
+// With 'persist' the change is also written to the log / binary file, and rolled back if that fails
+// (log compaction is left to exclusive writers, see isConcurrentLogCompactionDue).
+inline enTransactionResult executeConcurrentTransactionOnSlots(string fileName, string delim, sConcurrentAccounts &accounts, enTransactionType type,
+                                                        int fromSlot, int toSlot, sMoney amount, bool persist)
+{
+    if (fromSlot == -1 && toSlot == -1)
+        return TransactionAccountNotFound;
+
+    unique_lock<mutex> first, second;
+    lockAccountStripes(accounts, fromSlot, toSlot, first, second);
+
+    vector<int> changedSlots;
+    enTransactionResult result = applyTransactionToSlots(*accounts.store, type, fromSlot, toSlot, amount, changedSlots);
+    if (result == TransactionDone && persist && !persistConcurrentTransaction(fileName, delim, accounts, changedSlots))
+    {
+        revertTransactionOnSlots(*accounts.store, type, changedSlots, amount);
+        return TransactionNotSaved;
+    }
+    return result;
+}
+
+inline enTransactionResult executeConcurrentTransaction(string fileName, string delim, sConcurrentAccounts &accounts, const sTransaction &transaction)
+{
+    const sClientStore &store = *accounts.store;
+    int fromSlot = findClientSlot(store, transaction.accountNumber);
+    int toSlot = (transaction.type == Transfer) ? findClientSlot(store, transaction.toAccountNumber) : -1;
+    return executeConcurrentTransactionOnSlots(fileName, delim, accounts, transaction.type, fromSlot, toSlot, transaction.amount, true);
+}
+
+// Total money of all live clients (exact, balances are whole cents)
+inline sMoney totalBalance(const sClientStore &store)
+{
+    sMoney total;
+    for (size_t slot = 0; slot < slotCount(store.clients); slot++)
+    {
+        if (!isSlotDeleted(store.clients, slot))
+            total += store.clients.balances[slot];
+    }
+    return total;
+}
+
+// *****************************************************************************************************************
+
+#endif
@@ -0,0 +1,147 @@
+#ifndef SIMD_FIND_H
+#define SIMD_FIND_H
+
+/*
+=======================================
+simdFind — vectorized substring search
+=======================================
+
+Shared by the delimiter splitters and the word replacer.
+
+simdFind(haystack, needle, from) returns the offset of the first occurrence of `needle` in
+`haystack` at or after `from`, or std::string_view::npos — exactly like std::string::find,
+always as a size_t (so lines longer than 32 KB are fine).
+
+How it works (first-and-last-byte filter):
+- Broadcast the needle's first and last byte into a vector register.
+- For a block of 64 (AVX2, two registers) or 16 (SSE2) start positions, compare the haystack at those positions
+  with the first byte and the haystack shifted by (needle length - 1) with the last byte.
+- Only positions where both bytes match are verified with memcmp, so a multi-byte delimiter
+  like "#||#" rarely needs a full comparison.
+
+AVX2 is used when the CPU supports it (checked once at runtime), otherwise SSE2 on x86,
+otherwise a portable scalar version of the same filter.
+*/
+
+#include <cstddef>
+#include <cstring>
+#include <string_view>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SIMD_FIND_X86 1
+#include <immintrin.h>
+#endif
+
+namespace simd_find_detail
+{
+    // Scalar first-and-last-byte filter; used for tails and on CPUs without SSE2/AVX2
+    inline size_t findScalar(const char *s, size_t n, const char *needle, size_t k, size_t from)
+    {
+        const char first = needle[0];
+        const char last = needle[k - 1];
+        for (size_t i = from; i + k <= n; i++)
+        {
+            if (s[i] == first && s[i + k - 1] == last && std::memcmp(s + i + 1, needle + 1, k > 2 ? k - 2 : 0) == 0)
+                return i;
+        }
+        return std::string_view::npos;
+    }
+
+#ifdef SIMD_FIND_X86
+    // Checks every candidate bit of 'mask' (bit j = start position i + j) with memcmp
+    inline size_t verifyCandidates(unsigned mask, const char *s, size_t i, const char *needle, size_t k)
+    {
+        while (mask != 0)
+        {
+            unsigned bit = __builtin_ctz(mask);
+            if (std::memcmp(s + i + bit + 1, needle + 1, k > 2 ? k - 2 : 0) == 0)
+                return i + bit;
+            mask &= mask - 1;
+        }
+        return std::string_view::npos;
+    }
+
+    __attribute__((target("sse2"))) inline size_t findSse2(const char *s, size_t n, const char *needle, size_t k, size_t from)
+    {
+        const __m128i first = _mm_set1_epi8(needle[0]);
+        const __m128i last = _mm_set1_epi8(needle[k - 1]);
+
+        size_t i = from;
+        for (; i + k - 1 + 16 <= n; i += 16)
+        {
+            __m128i blockFirst = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i));
+            __m128i blockLast = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i + k - 1));
+            __m128i both = _mm_and_si128(_mm_cmpeq_epi8(blockFirst, first), _mm_cmpeq_epi8(blockLast, last));
+
+            unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(both));
+            size_t found = verifyCandidates(mask, s, i, needle, k);
+            if (found != std::string_view::npos)
+                return found;
+        }
+        return findScalar(s, n, needle, k, i);
+    }
+
+    __attribute__((target("avx2"))) inline size_t findAvx2(const char *s, size_t n, const char *needle, size_t k, size_t from)
+    {
+        const __m256i first = _mm256_set1_epi8(needle[0]);
+        const __m256i last = _mm256_set1_epi8(needle[k - 1]);
+
+        size_t i = from;
+
+        // Two blocks per iteration; the candidate masks are only inspected when either block has one,
+        // so long stretches without the delimiter run at close to memory speed
+        for (; i + k - 1 + 64 <= n; i += 64)
+        {
+            const char *p = s + i;
+            __m256i both0 = _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)), first),
+                                             _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + k - 1)), last));
+            __m256i both1 = _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + 32)), first),
+                                             _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + 32 + k - 1)), last));
+            if (_mm256_testz_si256(_mm256_or_si256(both0, both1), _mm256_or_si256(both0, both1)))
+                continue;
+
+            size_t found = verifyCandidates(static_cast<unsigned>(_mm256_movemask_epi8(both0)), s, i, needle, k);
+            if (found == std::string_view::npos)
+                found = verifyCandidates(static_cast<unsigned>(_mm256_movemask_epi8(both1)), s, i + 32, needle, k);
+            if (found != std::string_view::npos)
+                return found;
+        }
+        return findSse2(s, n, needle, k, i);
+    }
+
+    inline bool cpuHasAvx2()
+    {
+        static const bool hasAvx2 = __builtin_cpu_supports("avx2");
+        return hasAvx2;
+    }
+#endif
+}
+
+inline size_t simdFind(std::string_view haystack, std::string_view needle, size_t from = 0)
+{
+    const size_t n = haystack.size();
+    const size_t k = needle.size();
+
+    if (from > n)
+        return std::string_view::npos;
+    if (k == 0)
+        return from;
+    if (k > n - from)
+        return std::string_view::npos;
+
+    if (k == 1)
+    {
+        const void *hit = std::memchr(haystack.data() + from, needle[0], n - from);
+        return hit ? static_cast<const char *>(hit) - haystack.data() : std::string_view::npos;
+    }
+
+#ifdef SIMD_FIND_X86
+    if (simd_find_detail::cpuHasAvx2())
+        return simd_find_detail::findAvx2(haystack.data(), n, needle.data(), k, from);
+    return simd_find_detail::findSse2(haystack.data(), n, needle.data(), k, from);
+#else
+    return simd_find_detail::findScalar(haystack.data(), n, needle.data(), k, from);
+#endif
+}
+
+#endif
@@ -0,0 +1,109 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <functional>
+#include "simd_find.h"
+
+using namespace std;
+/*
+=======================================
+simdFind Microbenchmark
+=======================================
+
+Compares simdFind (simd_find.h) with std::string::find when counting "#||#"-style delimiters:
+- Client lines : many short records, a delimiter every ~10 bytes (the Clients.txt case).
+- Long line    : one 16 MB line with a delimiter every ~4 KB (lines that used to break `short pos`).
+- No match     : 16 MB of text that contains the first byte of the delimiter but never the delimiter.
+- Near misses  : "#|| " everywhere, so the first/last-byte filter has to reject almost every candidate.
+
+Build: g++ -std=c++17 -O2 simd_find_bench.cpp -o simd_find_bench
+*/
+
+// Builds text shaped like Clients.txt
+string makeClientLines(size_t bytes, const string &delim)
+{
+    string text;
+    for (size_t n = 0; text.size() < bytes; n++)
+    {
+        text += "AC" + to_string(10000000 + n) + delim + "1234" + delim + "Client Name Number " + to_string(n) + delim +
+                "01012345678" + delim + to_string(n * 7 % 100000) + ".000000\n";
+    }
+    return text;
+}
+
+string makeLongLine(size_t bytes, const string &delim)
+{
+    string text;
+    while (text.size() < bytes)
+        text += string(4096, 'x') + delim;
+    return text;
+}
+
+string makeRepeated(size_t bytes, const string &pattern)
+{
+    string text;
+    while (text.size() < bytes)
+        text += pattern;
+    return text;
+}
+
+// Runs 'count' several times and returns the best MB/s
+double bestMegabytesPerSecond(const string &text, function<size_t()> count, size_t &matches)
+{
+    double best = 0;
+    for (int run = 0; run < 5; run++)
+    {
+        auto start = chrono::steady_clock::now();
+        matches = count();
+        chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+        best = max(best, text.size() / (1024.0 * 1024.0) / elapsed.count());
+    }
+    return best;
+}
+
+void benchmarkCase(const string &name, const string &text, const string &delim)
+{
+    size_t stdMatches = 0, simdMatches = 0;
+
+    double stdSpeed = bestMegabytesPerSecond(text, [&]()
+                                             {
+                                                 size_t matches = 0;
+                                                 for (size_t pos = 0; (pos = text.find(delim, pos)) != string::npos; pos += delim.size())
+                                                     matches++;
+                                                 return matches; },
+                                             stdMatches);
+
+    double simdSpeed = bestMegabytesPerSecond(text, [&]()
+                                              {
+                                                  size_t matches = 0;
+                                                  for (size_t pos = 0; (pos = simdFind(text, delim, pos)) != string::npos; pos += delim.size())
+                                                      matches++;
+                                                  return matches; },
+                                              simdMatches);
+
+    cout << "| " << left << setw(14) << name;
+    cout << "| " << right << setw(9) << stdMatches << " ";
+    cout << "| " << setw(12) << fixed << setprecision(1) << stdSpeed << " ";
+    cout << "| " << setw(12) << simdSpeed << " ";
+    cout << "| " << setw(6) << setprecision(2) << simdSpeed / stdSpeed << "x";
+    cout << (stdMatches == simdMatches ? "" : "  MISMATCH!") << "\n";
+}
+
+int main()
+{
+    const string delim = "#||#";
+    const size_t bytes = 16 * 1024 * 1024;
+
+    cout << "Delimiter: \"" << delim << "\", " << bytes / (1024 * 1024) << " MB per case, best of 5 runs\n\n";
+    cout << "| Case          | Matches   | find MB/s    | simdFind MB/s| Speedup\n";
+    cout << "|---------------|-----------|--------------|--------------|--------\n";
+
+    benchmarkCase("Client lines", makeClientLines(bytes, delim), delim);
+    benchmarkCase("Long line", makeLongLine(bytes, delim), delim);
+    benchmarkCase("No match", makeRepeated(bytes, "abc#def|ghi "), delim);
+    benchmarkCase("Near misses", makeRepeated(bytes, "#|| "), delim);
+
+    return 0;
+}